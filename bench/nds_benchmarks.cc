@@ -0,0 +1,473 @@
+//
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+//
+#include "nds/nds_batch.h"
+#include "nds/nds_geojson.h"
+#include "nds/nds_morton_index.h"
+#include "nds/nds_morton_stream.h"
+#include "nds/nds_packed_id_set.h"
+#include "nds/nds_tile.h"
+#include "nds/nds_tile_cover.h"
+#include "nds/nds_tile_set.h"
+
+namespace nds {
+namespace {
+/*
+ * Number of points per data set, large enough to leave the L2 cache for the
+ * tile and coordinate arrays.
+ */
+constexpr size_t kPoints = 1 << 16;
+
+/*
+ * The point distributions, selected by the first benchmark argument.
+ */
+enum Distribution { kUniform = 0, kCity = 1, kCitySorted = 2 };
+
+const char *distributionName(int distribution) {
+  switch (distribution) {
+  case kUniform:
+    return "uniform";
+  case kCity:
+    return "city";
+  case kCitySorted:
+    return "city_sorted";
+  }
+  return "";
+}
+
+struct Points {
+  std::vector<double> lon;
+  std::vector<double> lat;
+  std::vector<int32_t> ndsLon;
+  std::vector<int32_t> ndsLat;
+  std::vector<int64_t> morton;
+};
+
+/*
+ * Uniform points over the whole world, or points normally distributed
+ * around Munich with a sigma of ~10 km. The sorted variant is in Morton
+ * order, like data read from a tiled map.
+ */
+const Points &points(int distribution) {
+  static Points sets[3];
+  Points &p = sets[distribution];
+  if (!p.lon.empty()) {
+    return p;
+  }
+  std::mt19937 rng(42 + distribution);
+  std::uniform_real_distribution<double> lonDist(-180, 180);
+  std::uniform_real_distribution<double> latDist(-90, 90);
+  std::normal_distribution<double> lonCity(11.575, 0.13);
+  std::normal_distribution<double> latCity(48.137, 0.09);
+  std::vector<NdsCoordinate> coords;
+  for (size_t i = 0; i < kPoints; i++) {
+    if (distribution == kUniform) {
+      coords.emplace_back(lonDist(rng), latDist(rng));
+    } else {
+      coords.emplace_back(lonCity(rng), latCity(rng));
+    }
+  }
+  if (distribution == kCitySorted) {
+    std::sort(coords.begin(), coords.end(),
+              [](const NdsCoordinate &a, const NdsCoordinate &b) {
+                return a.getMortonCode() < b.getMortonCode();
+              });
+  }
+  for (NdsCoordinate c : coords) {
+    Wgs84Coordinate w = c.toWGS84();
+    p.lon.push_back(w.longitude());
+    p.lat.push_back(w.latitude());
+    p.ndsLon.push_back(c.longitude());
+    p.ndsLat.push_back(c.latitude());
+    p.morton.push_back(c.getMortonCode());
+  }
+  return p;
+}
+
+std::vector<NdsTile> tiles(int distribution, int level) {
+  const Points &p = points(distribution);
+  std::vector<NdsTile> result;
+  for (size_t i = 0; i < kPoints; i++) {
+    result.emplace_back(level, NdsCoordinate(p.ndsLon[i], p.ndsLat[i]));
+  }
+  return result;
+}
+
+void finish(benchmark::State &state, size_t itemsPerIteration) {
+  state.SetItemsProcessed(state.iterations() * itemsPerIteration);
+  state.SetLabel(distributionName((int)state.range(0)));
+}
+
+void distributions(benchmark::internal::Benchmark *b) {
+  b->Arg(kUniform)->Arg(kCity)->Arg(kCitySorted);
+}
+
+/*
+ * Distribution x SimdLevel for the batch kernels.
+ */
+void distributionsAndSimdLevels(benchmark::internal::Benchmark *b) {
+  for (int distribution : {kUniform, kCity, kCitySorted}) {
+    for (int simd = 0; simd <= (int)maxSimdLevel(); simd++) {
+      b->Args({distribution, simd});
+    }
+  }
+}
+} // namespace
+
+void BM_Wgs84ToNds(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  for (auto _ : state) {
+    for (size_t i = 0; i < kPoints; i++) {
+      benchmark::DoNotOptimize(NdsCoordinate(p.lon[i], p.lat[i]));
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_Wgs84ToNds)->Apply(distributions);
+
+void BM_Wgs84ToNdsBatch(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  std::vector<int32_t> lon(kPoints), lat(kPoints);
+  for (auto _ : state) {
+    convertWgs84ToNds(p.lon.data(), p.lat.data(), kPoints, lon.data(),
+                      lat.data(), nullptr, (SimdLevel)state.range(1));
+    benchmark::ClobberMemory();
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_Wgs84ToNdsBatch)->Apply(distributionsAndSimdLevels);
+
+void BM_MortonEncode(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  for (auto _ : state) {
+    for (size_t i = 0; i < kPoints; i++) {
+      benchmark::DoNotOptimize(
+          NdsCoordinate(p.ndsLon[i], p.ndsLat[i]).getMortonCode());
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_MortonEncode)->Apply(distributions);
+
+void BM_MortonEncodeBatch(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  std::vector<int64_t> morton(kPoints);
+  for (auto _ : state) {
+    encodeMortonCodes(p.ndsLon.data(), p.ndsLat.data(), kPoints,
+                      morton.data(), (SimdLevel)state.range(1));
+    benchmark::ClobberMemory();
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_MortonEncodeBatch)->Apply(distributionsAndSimdLevels);
+
+void BM_MortonDecode(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  for (auto _ : state) {
+    for (size_t i = 0; i < kPoints; i++) {
+      benchmark::DoNotOptimize(NdsCoordinate(p.morton[i]));
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_MortonDecode)->Apply(distributions);
+
+void BM_MortonDecodeBatch(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  std::vector<int32_t> lon(kPoints), lat(kPoints);
+  for (auto _ : state) {
+    decodeMortonCodes(p.morton.data(), kPoints, lon.data(), lat.data(),
+                      (SimdLevel)state.range(1));
+    benchmark::ClobberMemory();
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_MortonDecodeBatch)->Apply(distributionsAndSimdLevels);
+
+void BM_PackedIdDecode(benchmark::State &state) {
+  std::vector<int> ids;
+  for (const NdsTile &tile : tiles((int)state.range(0), 13)) {
+    ids.push_back(tile.packedId());
+  }
+  for (auto _ : state) {
+    for (int id : ids) {
+      benchmark::DoNotOptimize(NdsTile(id));
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_PackedIdDecode)->Apply(distributions);
+
+void BM_PackedIdDecodeBatch(benchmark::State &state) {
+  std::vector<int32_t> ids;
+  for (const NdsTile &tile : tiles((int)state.range(0), 13)) {
+    ids.push_back(tile.packedId());
+  }
+  std::vector<int32_t> levels(kPoints), numbers(kPoints);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(decodePackedTileIds(ids.data(), kPoints,
+                                                 levels.data(), numbers.data(),
+                                                 (SimdLevel)state.range(1)));
+    benchmark::ClobberMemory();
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_PackedIdDecodeBatch)->Apply(distributionsAndSimdLevels);
+
+void BM_TileFromWgs84(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  for (auto _ : state) {
+    for (size_t i = 0; i < kPoints; i++) {
+      benchmark::DoNotOptimize(
+          NdsTile(13, Wgs84Coordinate(p.lon[i], p.lat[i])).packedId());
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_TileFromWgs84)->Apply(distributions);
+
+void BM_GetBBox(benchmark::State &state) {
+  std::vector<NdsTile> t = tiles((int)state.range(0), 13);
+  for (auto _ : state) {
+    for (const NdsTile &tile : t) {
+      benchmark::DoNotOptimize(tile.getBBox());
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_GetBBox)->Apply(distributions);
+
+void BM_GetCenter(benchmark::State &state) {
+  std::vector<NdsTile> t = tiles((int)state.range(0), 13);
+  for (auto _ : state) {
+    for (const NdsTile &tile : t) {
+      benchmark::DoNotOptimize(tile.getCenter());
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_GetCenter)->Apply(distributions);
+
+void BM_Contains(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  std::vector<NdsTile> t = tiles((int)state.range(0), 13);
+  // Check each point against the tile of the next point, so both outcomes
+  // occur.
+  for (auto _ : state) {
+    for (size_t i = 0; i < kPoints; i++) {
+      benchmark::DoNotOptimize(t[(i + 1) % kPoints].contains(
+          NdsCoordinate(p.ndsLon[i], p.ndsLat[i])));
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_Contains)->Apply(distributions);
+
+void BM_TileWindow(benchmark::State &state) {
+  std::vector<NdsTile> t = tiles((int)state.range(0), 13);
+  for (auto _ : state) {
+    for (const NdsTile &tile : t) {
+      benchmark::DoNotOptimize(tile.window());
+    }
+  }
+  finish(state, kPoints);
+}
+BENCHMARK(BM_TileWindow)->Apply(distributions);
+
+void BM_TileToGeoJSON(benchmark::State &state) {
+  std::vector<NdsTile> t = tiles((int)state.range(0), 13);
+  t.erase(t.begin() + 1024, t.end());
+  for (auto _ : state) {
+    for (const NdsTile &tile : t) {
+      benchmark::DoNotOptimize(tile.toGeoJSON());
+    }
+  }
+  finish(state, t.size());
+}
+BENCHMARK(BM_TileToGeoJSON)->Apply(distributions);
+
+void BM_TileToGeoJSONBuffer(benchmark::State &state) {
+  std::vector<NdsTile> t = tiles((int)state.range(0), 13);
+  t.erase(t.begin() + 1024, t.end());
+  char buffer[geojson::kMaxPolygonSize];
+  for (auto _ : state) {
+    for (const NdsTile &tile : t) {
+      benchmark::DoNotOptimize(geojson::writeTile(tile, buffer));
+    }
+    benchmark::ClobberMemory();
+  }
+  finish(state, t.size());
+}
+BENCHMARK(BM_TileToGeoJSONBuffer)->Apply(distributions);
+
+void BM_CoverRadius(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  size_t i = 0;
+  for (auto _ : state) {
+    NdsCoordinate center(p.ndsLon[i], p.ndsLat[i]);
+    benchmark::DoNotOptimize(coverRadius(center, 1000, 13));
+    i = (i + 1) % kPoints;
+  }
+  finish(state, 1);
+}
+BENCHMARK(BM_CoverRadius)->Apply(distributions);
+
+void BM_CoverRanges(benchmark::State &state) {
+  // Germany at level 15, ~17 million tiles in ~4000 ranges.
+  Wgs84Bbox germany(55.1, 15.1, 47.2, 5.8);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(coverRanges(germany, 15));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CoverRanges);
+
+void BM_CoverPolygon(benchmark::State &state) {
+  // Most of the eastern hemisphere at level 15, whose interior is emitted
+  // without descending to the tiles.
+  std::vector<std::vector<Wgs84Coordinate>> rings = {
+      {Wgs84Coordinate(-1, -89), Wgs84Coordinate(179, -89),
+       Wgs84Coordinate(179, 89), Wgs84Coordinate(-1, 89)}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(coverPolygon(rings, 15));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CoverPolygon);
+
+void BM_CoverPolyline(benchmark::State &state) {
+  // A ~1000 km route from Hamburg to Munich with a 2 km corridor.
+  std::vector<Wgs84Coordinate> route;
+  for (int i = 0; i <= 1000; i++) {
+    double t = i / 1000.0;
+    route.emplace_back(9.99 + t * (11.58 - 9.99) + 0.2 * std::sin(t * 20),
+                       53.55 + t * (48.14 - 53.55));
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(coverPolyline(route, 13, 2000));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CoverPolyline);
+
+void BM_MortonIndexQuery(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  std::vector<uint64_t> payloads(kPoints);
+  MortonIndex index(p.ndsLon.data(), p.ndsLat.data(), payloads.data(),
+                    kPoints);
+  // Boxes of ~4 x 4 km around the points.
+  const int kHalfSize = 200000;
+  size_t i = 0;
+  for (auto _ : state) {
+    int64_t lon = p.ndsLon[i], lat = p.ndsLat[i];
+    NdsBbox box((int)std::min<int64_t>(lat + kHalfSize, kMaxLatitude),
+                (int)(uint32_t)(lon + kHalfSize),
+                (int)std::max<int64_t>(lat - kHalfSize, kMinLatitude),
+                (int)(uint32_t)(lon - kHalfSize));
+    benchmark::DoNotOptimize(index.query(box));
+    i = (i + 1) % kPoints;
+  }
+  finish(state, 1);
+}
+BENCHMARK(BM_MortonIndexQuery)->Apply(distributions);
+
+/*
+ * Random level 13 packed Tile IDs, the set size is the benchmark argument,
+ * and lookups of which half are contained.
+ */
+struct PackedIdLookups {
+  std::vector<int> ids;
+  std::vector<int> queries;
+};
+
+PackedIdLookups packedIdLookups(size_t size) {
+  std::mt19937 rng(17);
+  PackedIdLookups l;
+  for (size_t i = 0; i < size; i++) {
+    l.ids.push_back(NdsTile(13, (int)(rng() % (1u << 27))).packedId());
+  }
+  for (size_t i = 0; i < kPoints; i++) {
+    l.queries.push_back(i % 2 ? l.ids[rng() % size]
+                              : NdsTile(13, (int)(rng() % (1u << 27)))
+                                    .packedId());
+  }
+  return l;
+}
+
+void BM_PackedIdSetContains(benchmark::State &state) {
+  PackedIdLookups l = packedIdLookups((size_t)state.range(0));
+  PackedIdSet set(l.ids);
+  for (auto _ : state) {
+    size_t found = 0;
+    for (int id : l.queries) {
+      found += set.contains(id) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * kPoints);
+}
+BENCHMARK(BM_PackedIdSetContains)->Arg(1 << 16)->Arg(8 << 20);
+
+void BM_PackedIdBinarySearch(benchmark::State &state) {
+  PackedIdLookups l = packedIdLookups((size_t)state.range(0));
+  std::sort(l.ids.begin(), l.ids.end());
+  for (auto _ : state) {
+    size_t found = 0;
+    for (int id : l.queries) {
+      found += std::binary_search(l.ids.begin(), l.ids.end(), id) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * kPoints);
+}
+BENCHMARK(BM_PackedIdBinarySearch)->Arg(1 << 16)->Arg(8 << 20);
+
+void BM_TileSetNormalize(benchmark::State &state) {
+  // A level 13 polygon cover of about 100k tiles, as shipped in tile lists.
+  std::vector<std::vector<Wgs84Coordinate>> polygon = {
+      {Wgs84Coordinate(5.9, 47.3), Wgs84Coordinate(15.0, 47.3),
+       Wgs84Coordinate(15.0, 51.0), Wgs84Coordinate(9.0, 55.0),
+       Wgs84Coordinate(5.9, 51.0)}};
+  PolygonCover cover = coverPolygon(polygon, 13);
+  TileSet set;
+  for (const std::vector<TileRange> *ranges :
+       {&cover.interior, &cover.boundary}) {
+    for (const TileRange &range : *ranges) {
+      set.insert(13, range);
+    }
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    TileSet normalized = set;
+    state.ResumeTiming();
+    normalized.normalize();
+    benchmark::DoNotOptimize(normalized);
+  }
+  state.SetItemsProcessed(state.iterations() * set.size());
+}
+BENCHMARK(BM_TileSetNormalize);
+
+void BM_MortonStreamDecode(benchmark::State &state) {
+  const Points &p = points((int)state.range(0));
+  std::vector<int64_t> sorted = p.morton;
+  std::sort(sorted.begin(), sorted.end());
+  MortonStream stream(sorted.data(), sorted.size());
+  std::vector<int64_t> codes;
+  for (auto _ : state) {
+    codes.clear();
+    stream.decode(&codes);
+    benchmark::DoNotOptimize(codes.data());
+  }
+  state.counters["bytes_per_code"] =
+      (double)stream.byteSize() / stream.size();
+  finish(state, kPoints);
+}
+BENCHMARK(BM_MortonStreamDecode)->Apply(distributions);
+
+} // namespace nds
+
+BENCHMARK_MAIN();
@@ -0,0 +1,393 @@
+#pragma once
+
+/**
+ * Differential check of the optimized coordinate, Morton and tile paths
+ * against the bit-by-bit reference implementation.
+ *
+ * An arbitrary byte buffer is decoded into WGS84 points, NDS points, Morton
+ * codes, packed Tile IDs and tile levels. Each value is run through the
+ * reference code and through every optimized path: the constexpr single
+ * object API, the runtime dispatched and the BMI2 Morton engines and the
+ * batch kernels of every SIMD level. Used by the libFuzzer target nds_fuzz
+ * and the deterministic nds_differential_test.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+//
+#include "nds/nds_batch.h"
+#include "nds/nds_coordinate.h"
+#include "nds/nds_morton.h"
+#include "nds/nds_tile.h"
+
+namespace nds {
+namespace differential {
+
+/*
+ * Reference semantics, written like the original implementation: the WGS84
+ * conversion, the tile number as shifted reference Morton code, the packed
+ * ID computed in 64 bits and truncated to 32 bits and the level search from
+ * level 15 down, where bit 31 is the sign bit.
+ */
+inline void referenceToNds(double lon, double lat, int32_t *ndsLon,
+                           int32_t *ndsLat) {
+  *ndsLat = (int32_t)std::floor(lat / 180.0 * kLatitudeRange);
+  *ndsLon = (int32_t)std::floor(lon / 360.0 * kLongitudeRange);
+}
+
+inline int32_t referencePackedId(int level, int32_t ndsLon, int32_t ndsLat) {
+  int64_t nr =
+      morton::encodeReference(ndsLon, ndsLat) >> (32 + (kMaxLevel - level) * 2);
+  return (int32_t)(uint32_t)(nr + (1LL << (16 + level)));
+}
+
+inline int referenceExtractLevel(int32_t packedId) {
+  for (int lvl = kMaxLevel; lvl > -1; lvl--) {
+    int64_t lvlBit = 1LL << (16 + lvl);
+    if (((int64_t)packedId & lvlBit) > 0) {
+      return lvl;
+    }
+    if (packedId < 0 && lvl == kMaxLevel) {
+      return kMaxLevel;
+    }
+  }
+  return -1;
+}
+
+inline int32_t referenceTileNumber(int32_t packedId) {
+  return (int32_t)((uint32_t)packedId ^
+                   (uint32_t)(1LL << (16 + referenceExtractLevel(packedId))));
+}
+
+/*
+ * Whether the tile number of a packed Tile ID is admissible for its level.
+ */
+inline bool referenceValidPackedId(int32_t packedId) {
+  int level = referenceExtractLevel(packedId);
+  return level >= 0 &&
+         (int64_t)referenceTileNumber(packedId) < (1LL << (2 * level + 1));
+}
+
+/*
+ * Reads the fuzzer input. Reads past the end yield zeros.
+ */
+class Input {
+public:
+  Input(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  bool empty() const { return size_ == 0; }
+
+  template <typename T> T take() {
+    uint8_t bytes[sizeof(T)] = {};
+    size_t n = size_ < sizeof(T) ? size_ : sizeof(T);
+    if (n > 0) {
+      std::memcpy(bytes, data_, n);
+      data_ += n;
+      size_ -= n;
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+  }
+
+  /*
+   * A value within [-limit, limit]: one of the edge cases, the raw bits if
+   * they form an admissible double or a uniformly scaled 53 bit fraction.
+   */
+  double takeDegrees(double limit) {
+    uint8_t kind = take<uint8_t>();
+    uint64_t bits = take<uint64_t>();
+    const double edges[] = {-limit,
+                            limit,
+                            0.0,
+                            -0.0,
+                            std::nextafter(limit, 0.0),
+                            std::nextafter(-limit, 0.0),
+                            std::numeric_limits<double>::denorm_min(),
+                            -std::numeric_limits<double>::denorm_min()};
+    const size_t edgeCount = sizeof(edges) / sizeof(edges[0]);
+    if (kind % 4 == 0) {
+      return edges[bits % edgeCount];
+    }
+    if (kind % 4 == 1) {
+      double raw;
+      std::memcpy(&raw, &bits, sizeof(raw));
+      if (raw >= -limit && raw <= limit) {
+        return raw;
+      }
+    }
+    return (double)(bits >> 11) * 0x1p-53 * 2 * limit - limit;
+  }
+
+private:
+  const uint8_t *data_;
+  size_t size_;
+};
+
+struct Values {
+  std::vector<double> lon;
+  std::vector<double> lat;
+  std::vector<int32_t> ndsLon;
+  std::vector<int32_t> ndsLat;
+  std::vector<int64_t> morton;
+  std::vector<int32_t> packedIds;
+  std::vector<int> levels;
+};
+
+/*
+ * The first two bytes select the tile levels, the following ones a sequence
+ * of tagged values.
+ */
+inline Values decodeValues(const uint8_t *data, size_t size) {
+  Input in(data, size);
+  Values v;
+  uint16_t levelMask = in.take<uint16_t>();
+  for (int level = 0; level <= kMaxLevel; level++) {
+    if (levelMask == 0 || (levelMask & 1 << level) != 0) {
+      v.levels.push_back(level);
+    }
+  }
+  const int32_t ndsEdges[] = {0,           -1,          1,
+                              kMaxLatitude, kMinLatitude, kMaxLongitude,
+                              kMinLongitude};
+  const size_t ndsEdgeCount = sizeof(ndsEdges) / sizeof(ndsEdges[0]);
+  while (!in.empty()) {
+    uint8_t tag = in.take<uint8_t>();
+    switch (tag % 4) {
+    case 0:
+      v.lon.push_back(in.takeDegrees(180.0));
+      v.lat.push_back(in.takeDegrees(90.0));
+      break;
+    case 1: {
+      int32_t lon = in.take<int32_t>();
+      // Arithmetic shift into the 31 bit latitude range.
+      int32_t lat = in.take<int32_t>() >> 1;
+      if (tag & 0x10) {
+        lon = ndsEdges[(uint32_t)lon % ndsEdgeCount];
+      }
+      if (tag & 0x20) {
+        lat = std::max(kMinLatitude,
+                       std::min(kMaxLatitude,
+                                ndsEdges[(uint32_t)lat % ndsEdgeCount]));
+      }
+      v.ndsLon.push_back(lon);
+      v.ndsLat.push_back(lat);
+      break;
+    }
+    case 2:
+      v.morton.push_back(in.take<int64_t>());
+      break;
+    default:
+      v.packedIds.push_back(in.take<int32_t>());
+      break;
+    }
+  }
+  return v;
+}
+
+const SimdLevel kSimdLevels[] = {SimdLevel::kScalar, SimdLevel::kSse2,
+                                 SimdLevel::kAvx2, SimdLevel::kAvx512};
+
+/*
+ * Collects the first mismatch.
+ */
+class Report {
+public:
+  template <typename T>
+  bool expect(const char *path, int simd, size_t index, const T &expected,
+              const T &actual) {
+    if (!out_.str().empty() || expected == actual) {
+      return expected == actual;
+    }
+    out_ << path << " (SIMD level " << simd << ", element " << index
+         << "): expected " << expected << ", got " << actual;
+    return false;
+  }
+  std::string str() const { return out_.str(); }
+
+private:
+  std::ostringstream out_;
+};
+
+inline void checkWgs84(const Values &v, Report *r) {
+  size_t n = v.lon.size();
+  std::vector<int32_t> refLon(n), refLat(n);
+  for (size_t i = 0; i < n; i++) {
+    referenceToNds(v.lon[i], v.lat[i], &refLon[i], &refLat[i]);
+    NdsCoordinate c(v.lon[i], v.lat[i]);
+    r->expect("NdsCoordinate(double, double).longitude", -1, i, refLon[i],
+              c.longitude());
+    r->expect("NdsCoordinate(double, double).latitude", -1, i, refLat[i],
+              c.latitude());
+  }
+  for (SimdLevel simd : kSimdLevels) {
+    std::vector<int32_t> lon(n), lat(n), ids(n * v.levels.size());
+    std::vector<int64_t> codes(n);
+    convertWgs84ToNds(v.lon.data(), v.lat.data(), n, lon.data(), lat.data(),
+                      codes.data(), simd);
+    for (size_t i = 0; i < n; i++) {
+      r->expect("convertWgs84ToNds lon", (int)simd, i, refLon[i], lon[i]);
+      r->expect("convertWgs84ToNds lat", (int)simd, i, refLat[i], lat[i]);
+      r->expect("convertWgs84ToNds morton", (int)simd, i,
+                morton::encodeReference(refLon[i], refLat[i]), codes[i]);
+    }
+    computePackedTileIds(v.lon.data(), v.lat.data(), n, v.levels.data(),
+                         v.levels.size(), ids.data(), simd);
+    for (size_t j = 0; j < v.levels.size(); j++) {
+      for (size_t i = 0; i < n; i++) {
+        r->expect("computePackedTileIds(double)", (int)simd, i,
+                  referencePackedId(v.levels[j], refLon[i], refLat[i]),
+                  ids[j * n + i]);
+      }
+    }
+    computePackedTileIds(v.lon.data(), v.lat.data(), n, v.levels.back(),
+                         ids.data(), simd);
+    for (size_t i = 0; i < n; i++) {
+      r->expect("computePackedTileIds(double, level)", (int)simd, i,
+                referencePackedId(v.levels.back(), refLon[i], refLat[i]),
+                ids[i]);
+    }
+  }
+}
+
+inline void checkNds(const Values &v, Report *r) {
+  size_t n = v.ndsLon.size();
+  std::vector<int64_t> ref(n);
+  for (size_t i = 0; i < n; i++) {
+    int32_t lon = v.ndsLon[i], lat = v.ndsLat[i];
+    ref[i] = morton::encodeReference(lon, lat);
+    r->expect("getMortonCode", -1, i, ref[i],
+              NdsCoordinate(lon, lat).getMortonCode());
+    r->expect("morton::encode", -1, i, ref[i], morton::encode(lon, lat));
+    r->expect("morton::encodePortable", -1, i, ref[i],
+              morton::encodePortable(lon, lat));
+    if (morton::bmi2Supported()) {
+      r->expect("morton::encodeBmi2", -1, i, ref[i],
+                morton::encodeBmi2(lon, lat));
+    }
+    for (int level : v.levels) {
+      r->expect("NdsTile(level, NdsCoordinate).packedId", -1, i,
+                referencePackedId(level, lon, lat),
+                NdsTile(level, NdsCoordinate(lon, lat)).packedId());
+    }
+  }
+  for (SimdLevel simd : kSimdLevels) {
+    std::vector<int64_t> codes(n);
+    std::vector<int32_t> ids(n * v.levels.size());
+    encodeMortonCodes(v.ndsLon.data(), v.ndsLat.data(), n, codes.data(),
+                      simd);
+    for (size_t i = 0; i < n; i++) {
+      r->expect("encodeMortonCodes", (int)simd, i, ref[i], codes[i]);
+    }
+    computePackedTileIds(v.ndsLon.data(), v.ndsLat.data(), n, v.levels.data(),
+                         v.levels.size(), ids.data(), simd);
+    for (size_t j = 0; j < v.levels.size(); j++) {
+      for (size_t i = 0; i < n; i++) {
+        r->expect("computePackedTileIds(int32)", (int)simd, i,
+                  referencePackedId(v.levels[j], v.ndsLon[i], v.ndsLat[i]),
+                  ids[j * n + i]);
+      }
+    }
+    computePackedTileIds(v.ndsLon.data(), v.ndsLat.data(), n, v.levels.front(),
+                         ids.data(), simd);
+    for (size_t i = 0; i < n; i++) {
+      r->expect("computePackedTileIds(int32, level)", (int)simd, i,
+                referencePackedId(v.levels.front(), v.ndsLon[i], v.ndsLat[i]),
+                ids[i]);
+    }
+  }
+}
+
+inline void checkMorton(const Values &v, Report *r) {
+  size_t n = v.morton.size();
+  std::vector<int32_t> refLon(n), refLat(n);
+  for (size_t i = 0; i < n; i++) {
+    int64_t code = v.morton[i];
+    morton::decodeReference(code, &refLon[i], &refLat[i]);
+    NdsCoordinate c(code);
+    r->expect("NdsCoordinate(int64).longitude", -1, i, refLon[i],
+              c.longitude());
+    r->expect("NdsCoordinate(int64).latitude", -1, i, refLat[i],
+              c.latitude());
+    int32_t lon = 0, lat = 0;
+    morton::decodePortable(code, &lon, &lat);
+    r->expect("morton::decodePortable lon", -1, i, refLon[i], lon);
+    r->expect("morton::decodePortable lat", -1, i, refLat[i], lat);
+    if (morton::bmi2Supported()) {
+      morton::decodeBmi2(code, &lon, &lat);
+      r->expect("morton::decodeBmi2 lon", -1, i, refLon[i], lon);
+      r->expect("morton::decodeBmi2 lat", -1, i, refLat[i], lat);
+    }
+  }
+  for (SimdLevel simd : kSimdLevels) {
+    std::vector<int32_t> lon(n), lat(n);
+    decodeMortonCodes(v.morton.data(), n, lon.data(), lat.data(), simd);
+    for (size_t i = 0; i < n; i++) {
+      r->expect("decodeMortonCodes lon", (int)simd, i, refLon[i], lon[i]);
+      r->expect("decodeMortonCodes lat", (int)simd, i, refLat[i], lat[i]);
+    }
+  }
+}
+
+inline void checkPackedIds(const Values &v, Report *r) {
+  size_t n = v.packedIds.size();
+  size_t refInvalid = 0;
+  for (size_t i = 0; i < n; i++) {
+    int32_t id = v.packedIds[i];
+    int refLevel = referenceExtractLevel(id);
+    refInvalid += refLevel < 0;
+    r->expect("NdsTile::extractLevel", -1, i, refLevel,
+              NdsTile::extractLevel(id));
+    Result<NdsTile> tile = NdsTile::fromPackedId(id);
+    r->expect("NdsTile::fromPackedId ok", -1, i, referenceValidPackedId(id),
+              tile.ok());
+    if (tile) {
+      r->expect("NdsTile(packedId).level", -1, i, refLevel,
+                tile.value().level());
+      r->expect("NdsTile(packedId).tileNumber", -1, i,
+                referenceTileNumber(id), tile.value().tileNumber());
+      r->expect("NdsTile(packedId).packedId", -1, i, id,
+                tile.value().packedId());
+    }
+  }
+  for (SimdLevel simd : kSimdLevels) {
+    std::vector<int32_t> levels(n), numbers(n);
+    size_t invalid = decodePackedTileIds(v.packedIds.data(), n, levels.data(),
+                                         numbers.data(), simd);
+    r->expect("decodePackedTileIds invalid count", (int)simd, n, refInvalid,
+              invalid);
+    for (size_t i = 0; i < n; i++) {
+      r->expect("decodePackedTileIds level", (int)simd, i,
+                referenceExtractLevel(v.packedIds[i]), levels[i]);
+      r->expect("decodePackedTileIds tile number", (int)simd, i,
+                referenceTileNumber(v.packedIds[i]), numbers[i]);
+    }
+  }
+}
+
+/**
+ * Runs all paths on the values decoded from the buffer.
+ *
+ * @param data
+ * @param size
+ * @return std::string empty if all paths agree with the reference, else a
+ *         description of the first mismatch
+ */
+inline std::string check(const uint8_t *data, size_t size) {
+  Values v = decodeValues(data, size);
+  Report r;
+  checkWgs84(v, &r);
+  checkNds(v, &r);
+  checkMorton(v, &r);
+  checkPackedIds(v, &r);
+  return r.str();
+}
+
+} // namespace differential
+} // namespace nds
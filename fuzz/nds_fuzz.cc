@@ -0,0 +1,16 @@
+/*
+ * libFuzzer target comparing the optimized paths with the reference
+ * implementation, see nds_differential.h. Build with -DBUILD_FUZZER=ON using
+ * clang and run e.g. ./nds_fuzz -max_len=4096 corpus/
+ */
+#include <glog/logging.h>
+//
+#include "nds_differential.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  std::string mismatch = nds::differential::check(data, size);
+  if (!mismatch.empty()) {
+    LOG(FATAL) << mismatch;
+  }
+  return 0;
+}
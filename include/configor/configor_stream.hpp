@@ -19,12 +19,16 @@
 // THE SOFTWARE.
 
 #pragma once
-#include <algorithm>    // std::none_of
+#include <algorithm>    // std::all_of
+#include <array>        // std::array
+#include <charconv>     // std::to_chars
 #include <cmath>        // std::ceil, std::floor
 #include <cstdio>       // std::FILE, std::fgetc, std::fgets, std::fgetwc, std::fgetws, std::snprintf
+#include <cstdlib>      // std::strtod
 #include <iomanip>      // std::fill, std::setw
 #include <ios>          // std::basic_ios, std::streamsize, std::hex, std::dec, std::uppercase, std::nouppercase
 #include <istream>      // std::basic_istream
+#include <limits>       // std::numeric_limits
 #include <ostream>      // std::basic_ostream
 #include <streambuf>    // std::streambuf
 #include <string>       // std::basic_string
@@ -526,21 +530,80 @@ struct snprintf_t
         internal_snprintf(os, buffer.data(), sizeof(buffer), "\\u%04X", val);
     }
 
+    // Formats a float like the stream: with std::fixed the precision is the number of decimals,
+    // trailing zeros are dropped. Otherwise the precision is the number of significant digits,
+    // a precision of 0 selects the shortest representation that reads back as the same value.
+    // Integral results get a ".0" suffix, so they are read back as float.
     template <typename _FloatTy>
     static inline void one_float(std::basic_ostream<char_type>& os, const _FloatTy val)
     {
-        std::array<char, 32> buffer = {};
+        std::array<char, 64> buffer = {};
+
+        const auto p     = static_cast<int>(os.precision());
+        const bool fixed = (os.flags() & std::ios_base::floatfield) == std::ios_base::fixed;
 
-        const auto p   = static_cast<int>(os.precision());
-        const auto len = internal_snprintf(os, buffer.data(), sizeof(buffer), "%.*g", p, val);
+        auto len     = fixed ? format_float(buffer.data(), buffer.size(), val, p, true) : -1;
+        bool trimmed = len > 0 && p > 0;
+        if (len < 0)
+        {
+            // general notation, or too many digits for fixed notation
+            len = format_float(buffer.data(), buffer.size(), val, fixed ? 0 : p, false);
+        }
+        if (len <= 0)
+        {
+            os.setstate(std::ios_base::failbit);
+            return;
+        }
+        if (trimmed)
+        {
+            while (len > 2 && buffer[len - 1] == '0' && buffer[len - 2] != '.')
+                --len;
+        }
+        copy_simple_string(os, buffer.data(), static_cast<size_t>(len));
         // determine if need to append ".0"
-        if (std::none_of(buffer.data(), buffer.data() + len + 1, [](char c) { return c == '.'; }))
+        if (std::all_of(buffer.data(), buffer.data() + len, [](char c) { return c == '-' || (c >= '0' && c <= '9'); }))
         {
             os.put(char_type('.')).put(char_type('0'));
         }
     }
 
 private:
+    template <typename _FloatTy>
+    static inline int format_float(char* buffer, size_t size, const _FloatTy val, const int precision,
+                                   const bool fixed)
+    {
+#if defined(__cpp_lib_to_chars)
+        std::to_chars_result result;
+        if (fixed)
+            result = std::to_chars(buffer, buffer + size, val, std::chars_format::fixed, precision);
+        else if (precision > 0)
+            result = std::to_chars(buffer, buffer + size, val, std::chars_format::general, precision);
+        else
+            result = std::to_chars(buffer, buffer + size, val);
+        if (result.ec != std::errc())
+            return -1;
+        return static_cast<int>(result.ptr - buffer);
+#else
+        int len = 0;
+        if (fixed)
+            len = std::snprintf(buffer, size, "%.*f", precision, static_cast<double>(val));
+        else if (precision > 0)
+            len = std::snprintf(buffer, size, "%.*g", precision, static_cast<double>(val));
+        else
+        {
+            // the fewest significant digits that read back as the same value
+            for (int p = std::numeric_limits<_FloatTy>::digits10; p <= std::numeric_limits<_FloatTy>::max_digits10;
+                 p++)
+            {
+                len = std::snprintf(buffer, size, "%.*g", p, static_cast<double>(val));
+                if (len > 0 && static_cast<_FloatTy>(std::strtod(buffer, nullptr)) == val)
+                    break;
+            }
+        }
+        return len < static_cast<int>(size) ? len : -1;
+#endif
+    }
+
     template <typename _IntTy>
     static inline void internal_one_integer(std::basic_ostream<char_type>& os, const char* format, const _IntTy val)
     {
@@ -637,26 +700,6 @@ struct serializable_float
         snprintf_t<_CharTy>::one_float(os, f.f);
         return os;
     }
-
-    friend std::basic_ostream<char>& operator<<(std::basic_ostream<char>& os, const serializable_float& f)
-    {
-        if (std::ceil(f.f) == std::floor(f.f))
-        {
-            // integer
-            return os << static_cast<int64_t>(f.f) << ".0";
-        }
-        return os << f.f;
-    }
-
-    friend std::basic_ostream<wchar_t>& operator<<(std::basic_ostream<wchar_t>& os, const serializable_float& f)
-    {
-        if (std::ceil(f.f) == std::floor(f.f))
-        {
-            // integer
-            return os << static_cast<int64_t>(f.f) << L".0";
-        }
-        return os << f.f;
-    }
 };
 
 namespace
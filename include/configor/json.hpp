@@ -87,6 +87,8 @@ std::basic_ostream<typename _JsonTy::char_type>& operator<<(std::basic_ostream<t
     args.indent      = static_cast<unsigned int>(os.width());
     args.indent_char = os.fill();
     args.precision   = static_cast<int>(os.precision());
+    if ((os.flags() & std::ios_base::floatfield) == std::ios_base::fixed)
+        args.decimals = args.precision;
 
     os.width(0);
     j.dump(os, args);
@@ -645,14 +647,18 @@ public:
         int       indent;
         char_type indent_char;
         bool      escape_unicode;
-        int       precision;
+        // significant digits of floats, 0 for the shortest representation that reads back as the same value
+        int precision;
+        // if not negative, floats are written with this number of decimals, without trailing zeros
+        int decimals;
 
-        args(int indent = 0, char_type indent_char = ' ', bool escape_unicode = false,
-             int precision = std::numeric_limits<float_type>::digits10 + 1)
+        args(int indent = 0, char_type indent_char = ' ', bool escape_unicode = false, int precision = 0,
+             int decimals = -1)
             : indent(indent)
             , indent_char(indent_char)
             , escape_unicode(escape_unicode)
             , precision(precision)
+            , decimals(decimals)
         {
         }
     };
@@ -689,7 +695,11 @@ public:
     {
         detail::copy_fmt(os, os_);
         os_.rdbuf(os.rdbuf());
-        os_ << std::setprecision(args_.precision) << std::right << std::noshowbase;
+        if (args_.decimals >= 0)
+            os_ << std::fixed << std::setprecision(args_.decimals);
+        else
+            os_ << std::defaultfloat << std::setprecision(args_.precision);
+        os_ << std::right << std::noshowbase;
 
         src_decoder_    = src_decoder;
         target_encoder_ = target_encoder;
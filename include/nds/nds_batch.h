@@ -0,0 +1,216 @@
+#pragma once
+
+/**
+ * Batch kernels operating on structure-of-arrays buffers.
+ *
+ * The kernels produce the same results as the corresponding single object
+ * operations, but avoid the per-object overhead and are vectorized with
+ * SSE2/AVX2/AVX-512. The instruction set is selected at runtime, see
+ * maxSimdLevel().
+ */
+#include <cstddef>
+#include <cstdint>
+
+namespace nds {
+
+/**
+ * Instruction set used by the batch kernels.
+ */
+enum class SimdLevel { kScalar = 0, kSse2 = 1, kAvx2 = 2, kAvx512 = 3 };
+
+/**
+ * Returns the best instruction set supported by the running CPU.
+ *
+ * @return SimdLevel
+ */
+SimdLevel maxSimdLevel();
+
+/**
+ * Converts arrays of WGS84 coordinates to NDS coordinates, identical to
+ * NdsCoordinate(double lon, double lat) applied to each element.
+ *
+ * Out-of-range input is fatal, like for the single coordinate constructor,
+ * and so is NaN. The check runs after the conversion, which never casts an
+ * invalid value to int32: the scalar kernel writes INT32_MIN for values
+ * outside the int32 range, like the x86 conversion instructions.
+ *
+ * @param lon
+ *                the longitudes within [-180, 180]
+ * @param lat
+ *                the latitudes within [-90, 90]
+ * @param count
+ *                the number of coordinates
+ * @param ndsLon
+ *                output, the NDS longitudes
+ * @param ndsLat
+ *                output, the NDS latitudes
+ * @param mortonCodes
+ *                optional output, the Morton codes of the coordinates
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ */
+void convertWgs84ToNds(const double *lon, const double *lat, size_t count,
+                       int32_t *ndsLon, int32_t *ndsLat,
+                       int64_t *mortonCodes = nullptr,
+                       SimdLevel level = maxSimdLevel());
+
+/**
+ * Computes the Morton codes of arrays of NDS coordinates, identical to
+ * NdsCoordinate::getMortonCode() applied to each element.
+ *
+ * @param ndsLon
+ *                the NDS longitudes
+ * @param ndsLat
+ *                the NDS latitudes
+ * @param count
+ *                the number of coordinates
+ * @param mortonCodes
+ *                output, the Morton codes
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ */
+void encodeMortonCodes(const int32_t *ndsLon, const int32_t *ndsLat,
+                       size_t count, int64_t *mortonCodes,
+                       SimdLevel level = maxSimdLevel());
+
+/**
+ * Splits an array of Morton codes into NDS longitudes and latitudes,
+ * identical to NdsCoordinate(int64_t) applied to each element.
+ *
+ * @param mortonCodes
+ *                the Morton codes
+ * @param count
+ *                the number of codes
+ * @param ndsLon
+ *                output, the NDS longitudes
+ * @param ndsLat
+ *                output, the NDS latitudes
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ */
+void decodeMortonCodes(const int64_t *mortonCodes, size_t count,
+                       int32_t *ndsLon, int32_t *ndsLat,
+                       SimdLevel level = maxSimdLevel());
+
+/**
+ * Computes the packed tile IDs of arrays of WGS84 coordinates, identical to
+ * NdsTile(tileLevel, Wgs84Coordinate(lon, lat)).packedId() applied to each
+ * element.
+ *
+ * Out-of-range input is fatal, like for the single tile constructor.
+ *
+ * @param lon
+ *                the longitudes within [-180, 180]
+ * @param lat
+ *                the latitudes within [-90, 90]
+ * @param count
+ *                the number of coordinates
+ * @param tileLevel
+ *                the tile level, must be in range 0..15
+ * @param packedIds
+ *                output, the packed tile IDs
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ */
+void computePackedTileIds(const double *lon, const double *lat, size_t count,
+                          int tileLevel, int32_t *packedIds,
+                          SimdLevel level = maxSimdLevel());
+
+/**
+ * Computes the packed tile IDs of arrays of WGS84 coordinates for several
+ * tile levels at once. The coordinates are converted only once.
+ *
+ * @param lon
+ *                the longitudes within [-180, 180]
+ * @param lat
+ *                the latitudes within [-90, 90]
+ * @param count
+ *                the number of coordinates
+ * @param tileLevels
+ *                the tile levels, each must be in range 0..15
+ * @param levelCount
+ *                the number of tile levels
+ * @param packedIds
+ *                output, levelCount * count packed tile IDs. The ID of
+ *                coordinate i at tileLevels[j] is stored at j * count + i.
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ */
+void computePackedTileIds(const double *lon, const double *lat, size_t count,
+                          const int *tileLevels, size_t levelCount,
+                          int32_t *packedIds,
+                          SimdLevel level = maxSimdLevel());
+
+/**
+ * Computes the packed tile IDs of arrays of NDS coordinates, identical to
+ * NdsTile(tileLevel, NdsCoordinate(ndsLon, ndsLat)).packedId() applied to
+ * each element.
+ *
+ * Out-of-range latitudes are fatal, like for the single tile constructor.
+ *
+ * @param ndsLon
+ *                the NDS longitudes
+ * @param ndsLat
+ *                the NDS latitudes
+ * @param count
+ *                the number of coordinates
+ * @param tileLevel
+ *                the tile level, must be in range 0..15
+ * @param packedIds
+ *                output, the packed tile IDs
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ */
+void computePackedTileIds(const int32_t *ndsLon, const int32_t *ndsLat,
+                          size_t count, int tileLevel, int32_t *packedIds,
+                          SimdLevel level = maxSimdLevel());
+
+/**
+ * Computes the packed tile IDs of arrays of NDS coordinates for several tile
+ * levels at once. The Morton codes are computed only once.
+ *
+ * @param ndsLon
+ *                the NDS longitudes
+ * @param ndsLat
+ *                the NDS latitudes
+ * @param count
+ *                the number of coordinates
+ * @param tileLevels
+ *                the tile levels, each must be in range 0..15
+ * @param levelCount
+ *                the number of tile levels
+ * @param packedIds
+ *                output, levelCount * count packed tile IDs. The ID of
+ *                coordinate i at tileLevels[j] is stored at j * count + i.
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ */
+void computePackedTileIds(const int32_t *ndsLon, const int32_t *ndsLat,
+                          size_t count, const int *tileLevels,
+                          size_t levelCount, int32_t *packedIds,
+                          SimdLevel level = maxSimdLevel());
+
+/**
+ * Splits packed tile IDs into tile levels and tile numbers, identical to
+ * NdsTile(packedId) applied to each element.
+ *
+ * IDs without level bit yield level -1 like for the single tile constructor,
+ * they are counted instead of logged.
+ *
+ * @param packedIds
+ *                the packed tile IDs
+ * @param count
+ *                the number of IDs
+ * @param tileLevels
+ *                output, the tile levels
+ * @param tileNumbers
+ *                output, the tile numbers
+ * @param level
+ *                the instruction set to use, capped at maxSimdLevel()
+ * @return size_t the number of IDs without level bit
+ */
+size_t decodePackedTileIds(const int32_t *packedIds, size_t count,
+                           int32_t *tileLevels, int32_t *tileNumbers,
+                           SimdLevel level = maxSimdLevel());
+
+} // namespace nds
@@ -7,16 +7,15 @@ namespace nds {
 class NdsBbox {
 
 public:
-  NdsBbox(int north, int east, int south, int west)
+  constexpr NdsBbox(int north, int east, int south, int west)
       : north_(north), east_(east), south_(south), west_(west) {}
-  ~NdsBbox() {}
 
-  int north() const { return north_; }
-  int east() const { return east_; }
-  int south() const { return south_; }
-  int west() const { return west_; }
+  constexpr int north() const { return north_; }
+  constexpr int east() const { return east_; }
+  constexpr int south() const { return south_; }
+  constexpr int west() const { return west_; }
 
-  bool operator==(const NdsBbox &other) {
+  constexpr bool operator==(const NdsBbox &other) const {
     return this->north_ == other.north_ && this->east_ == other.east_ &&
            this->south_ == other.south_ && this->west_ == other.west_;
   }
@@ -25,7 +24,7 @@ public:
    number
    * 0 on level 0
    */
-  static NdsBbox WEST_HEMISPHERE() {
+  static constexpr NdsBbox WEST_HEMISPHERE() {
     return NdsBbox(kMaxLatitude, 0, kMinLatitude, kMinLongitude);
   }
   /**
@@ -33,7 +32,7 @@ public:
    number
    * 1 on level 0
    */
-  static NdsBbox EAST_HEMISPHERE() {
+  static constexpr NdsBbox EAST_HEMISPHERE() {
     return NdsBbox(kMaxLatitude, kMaxLongitude, kMinLatitude, 0);
   }
   /**
@@ -42,34 +41,42 @@ public:
    *
    * @return
    */
-  NdsCoordinate southWest() { return NdsCoordinate(west_, south_); }
+  constexpr NdsCoordinate southWest() const {
+    return NdsCoordinate(west_, south_);
+  }
   /**
    * Gets the south east corner of the bounding box
    *
    * @return NdsCoordinate
    */
-  NdsCoordinate southEast() { return NdsCoordinate(east_, south_); }
+  constexpr NdsCoordinate southEast() const {
+    return NdsCoordinate(east_, south_);
+  }
 
   /**
    * Gets the north west corner of the bounding box
    *
    * @return NdsCoordinate
    */
-  NdsCoordinate northWest() { return NdsCoordinate(west_, north_); }
+  constexpr NdsCoordinate northWest() const {
+    return NdsCoordinate(west_, north_);
+  }
 
   /**
    * Gets the north east corner of the bounding box
    *
    * @return NdsCoordinate
    */
-  NdsCoordinate northEast() { return NdsCoordinate(east_, north_); }
+  constexpr NdsCoordinate northEast() const {
+    return NdsCoordinate(east_, north_);
+  }
 
   /**
    * Returns the center of the bounding box
    *
    * @return NdsCoordinate
    */
-  NdsCoordinate center() {
+  constexpr NdsCoordinate center() const {
     int32_t lon = (int64_t(east_) + int64_t(west_)) / 2;
     int32_t lat = (int64_t(north_) + int64_t(south_)) / 2;
     return NdsCoordinate(lon, lat);
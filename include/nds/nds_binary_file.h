@@ -0,0 +1,215 @@
+#pragma once
+
+/**
+ * Binary files of NDS coordinates, Morton codes and packed Tile IDs, for
+ * passing large arrays between pipeline stages without parsing.
+ *
+ * Layout, all numbers little endian:
+ *
+ *   header      64 bytes: magic "NDSB", u32 version, u64 offset of the
+ *               section table, u32 number of sections, zero padding
+ *   sections    fixed width arrays, each starting at a multiple of 64 bytes
+ *   table       32 bytes per section: u32 type, i32 tile level (-1 if none),
+ *               u32 element size, u32 zero, u64 offset, u64 element count
+ *
+ * Coordinates are stored as two sections of longitudes and latitudes, like
+ * the arrays of the batch functions. Packed Tile ID sections may carry a tile
+ * level, so the table is an index of the per level sections.
+ *
+ * BinaryFile maps a file into memory and returns the sections as spans
+ * pointing into the mapping, nothing is copied or converted. Only little
+ * endian hosts are supported.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+//
+#include "nds/nds_coordinate.h"
+#include "nds/nds_status.h"
+#include "nds/nds_tile_set.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "nds binary files require a little endian host"
+#endif
+
+namespace nds {
+
+enum class SectionType : uint32_t {
+  kLongitudes = 1,
+  kLatitudes = 2,
+  kMortonCodes = 3,
+  kPackedTileIds = 4
+};
+
+/**
+ * A read-only view of an array.
+ */
+template <typename T> struct Span {
+  const T *data = nullptr;
+  size_t size = 0;
+
+  const T *begin() const { return data; }
+  const T *end() const { return data + size; }
+  const T &operator[](size_t i) const { return data[i]; }
+  bool empty() const { return size == 0; }
+};
+
+/**
+ * An entry of the section table.
+ */
+struct BinarySection {
+  SectionType type;
+  int level;
+  uint64_t offset;
+  uint64_t count;
+};
+
+/**
+ * Writes a binary file section by section. The table is appended and the
+ * header completed by finish() or the destructor.
+ */
+class BinaryFileWriter {
+public:
+  static constexpr uint32_t kVersion = 1;
+
+  /**
+   * Creates or truncates the file.
+   *
+   * @param path
+   */
+  explicit BinaryFileWriter(const std::string &path);
+  ~BinaryFileWriter();
+  BinaryFileWriter(const BinaryFileWriter &) = delete;
+  BinaryFileWriter &operator=(const BinaryFileWriter &) = delete;
+
+  /**
+   * Adds a longitude and a latitude section.
+   *
+   * @param ndsLon
+   * @param ndsLat
+   * @param count
+   */
+  void addCoordinates(const int32_t *ndsLon, const int32_t *ndsLat,
+                      size_t count);
+  void addCoordinates(const std::vector<NdsCoordinate> &coords);
+  void addMortonCodes(const int64_t *codes, size_t count);
+  /**
+   * Adds a section of packed Tile IDs.
+   *
+   * @param packedIds
+   * @param count
+   * @param level
+   *                the level of all tiles, or -1 for mixed levels
+   */
+  void addPackedTileIds(const int32_t *packedIds, size_t count,
+                        int level = -1);
+  /**
+   * Adds one packed Tile ID section per non-empty level of the set, in
+   * Morton order.
+   *
+   * @param tiles
+   */
+  void addTileSet(const TileSet &tiles);
+
+  /**
+   * Writes the section table and the header and closes the file. Further
+   * sections are ignored.
+   *
+   * @return Status kOk, or Status::kIoError if writing failed
+   */
+  Status finish();
+
+private:
+  void beginSection(SectionType type, int level);
+  void write(const void *data, size_t size);
+  void endSection(uint64_t count);
+
+  std::ofstream out_;
+  uint64_t offset_ = 0;
+  std::vector<BinarySection> sections_;
+  bool finished_ = false;
+};
+
+/**
+ * A binary file mapped into memory.
+ */
+class BinaryFile {
+public:
+  /**
+   * Maps the file and validates header and section table.
+   *
+   * @param path
+   * @return Result<BinaryFile> the file, or Status::kIoError if it cannot be
+   *         mapped, or Status::kInvalidData if it is truncated or malformed
+   */
+  static Result<BinaryFile> open(const std::string &path);
+  /**
+   * Validates a binary file in memory without copying it. The data must be
+   * aligned to 8 bytes and outlive the BinaryFile.
+   *
+   * @param data
+   * @param size
+   * @return Result<BinaryFile> the file, or Status::kInvalidData if it is
+   *         misaligned, truncated or malformed
+   */
+  static Result<BinaryFile> parse(const uint8_t *data, size_t size);
+
+  BinaryFile(BinaryFile &&other) noexcept;
+  BinaryFile &operator=(BinaryFile &&other) noexcept;
+  ~BinaryFile();
+
+  const std::vector<BinarySection> &sections() const { return sections_; }
+  /**
+   * Returns the first section of the type and level.
+   *
+   * @param type
+   * @param level
+   *                the tile level, -1 for sections without level
+   * @return const BinarySection* or nullptr
+   */
+  const BinarySection *find(SectionType type, int level = -1) const;
+
+  /**
+   * The elements of a section, which must be of type kLongitudes,
+   * kLatitudes or kPackedTileIds.
+   *
+   * @param section
+   * @return Span<int32_t>
+   */
+  Span<int32_t> int32s(const BinarySection &section) const;
+  /**
+   * The elements of a section, which must be of type kMortonCodes.
+   *
+   * @param section
+   * @return Span<int64_t>
+   */
+  Span<int64_t> int64s(const BinarySection &section) const;
+
+  /*
+   * The first section of the type, empty if there is none.
+   */
+  Span<int32_t> longitudes() const;
+  Span<int32_t> latitudes() const;
+  Span<int64_t> mortonCodes() const;
+  /**
+   * The packed Tile IDs of the first section of the level.
+   *
+   * @param level
+   *                the tile level, -1 for the section of mixed levels
+   * @return Span<int32_t> empty if there is no such section
+   */
+  Span<int32_t> packedTileIds(int level = -1) const;
+
+private:
+  BinaryFile() = default;
+  void unmap();
+
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<BinarySection> sections_;
+};
+
+} // namespace nds
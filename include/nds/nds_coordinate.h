@@ -22,6 +22,8 @@
 #include <limits>
 #include <string>
 //
+#include "nds/nds_morton.h"
+#include "nds/nds_status.h"
 #include "nds/wgs84_coordinate.h"
 
 namespace nds {
@@ -44,7 +46,12 @@ public:
    * @param longitude
    * @param latitude
    */
-  NdsCoordinate(int longitude, int latitude);
+  constexpr NdsCoordinate(int longitude, int latitude)
+      : latitude_(latitude), longitude_(longitude) {
+    if (latitude < kMinLatitude || kMaxLatitude < latitude) {
+      verify(longitude, latitude);
+    }
+  }
   /**
    * Instantiates a new NDS coordinate from WGS84 coordinates.
    *
@@ -61,7 +68,42 @@ public:
    * @param ndsMortonCoordinates
    * @return
    */
-  NdsCoordinate(int64_t ndsMortonCoordinates);
+  constexpr NdsCoordinate(int64_t ndsMortonCoordinates) {
+    /*
+     * with NDS, the latitude value is considered a 31-bit signed integer.
+     * hence, if the 31st bit is 1, this means we have a negative integer. The
+     * decoder extends the sign to the 32st bit, so the latitude is always in
+     * range.
+     */
+    if (NDS_CONSTANT_EVALUATED()) {
+      morton::decodePortable(ndsMortonCoordinates, &longitude_, &latitude_);
+    } else {
+      morton::decode(ndsMortonCoordinates, &longitude_, &latitude_);
+    }
+  }
+
+  /**
+   * Creates a new NdsCoordinate without aborting on invalid input.
+   *
+   * @param longitude
+   * @param latitude
+   *                the latitude within [-2^30; 2^30]
+   * @return Result<NdsCoordinate> the coordinate, or Status::kInvalidLatitude
+   */
+  static Result<NdsCoordinate> create(int longitude, int latitude);
+
+  /**
+   * Creates a new NdsCoordinate from WGS84 coordinates without aborting on
+   * invalid input.
+   *
+   * @param lon
+   *                the longitude within [-180, 180]
+   * @param lat
+   *                the latitude within [-90, 90]
+   * @return Result<NdsCoordinate> the coordinate, or
+   *         Status::kInvalidLongitude / Status::kInvalidLatitude
+   */
+  static Result<NdsCoordinate> create(double lon, double lat);
 
   /**
    * Adds an offset specified by two int values to the coordinate.
@@ -80,7 +122,12 @@ public:
    *
    * @return long
    */
-  int64_t getMortonCode();
+  constexpr int64_t getMortonCode() const {
+    if (NDS_CONSTANT_EVALUATED()) {
+      return morton::encodePortable(longitude_, latitude_);
+    }
+    return morton::encode(longitude_, latitude_);
+  }
 
   /**
    *
@@ -97,19 +144,24 @@ public:
    */
   std::string toGeoJSON();
 
-  int latitude() const { return latitude_; }
-  int longitude() const { return longitude_; }
+  constexpr int latitude() const { return latitude_; }
+  constexpr int longitude() const { return longitude_; }
 
-  bool operator==(const NdsCoordinate &other) {
+  constexpr bool operator==(const NdsCoordinate &other) const {
     return this->latitude_ == other.latitude_ &&
            this->longitude_ == other.longitude_;
   }
 
 private:
+  constexpr NdsCoordinate() = default;
+
+  /*
+   * Logs a fatal error for an out-of-range latitude.
+   */
   bool verify(int lon, int lat);
 
-  int latitude_;
-  int longitude_;
+  int latitude_ = 0;
+  int longitude_ = 0;
 };
 inline std::ostream &operator<<(std::ostream &out, const NdsCoordinate &other) {
   out << "latitude: " << other.latitude()
@@ -0,0 +1,245 @@
+#pragma once
+
+/**
+ * Streaming GeoJSON writer.
+ *
+ * Writes the "Feature" text of coordinates, bounding boxes and tiles directly
+ * into a character buffer, without building a JSON document first. The text
+ * is identical to the one of the toGeoJSON() methods and the configor
+ * serializer: members in alphabetical order, "properties" null and numbers in
+ * the shortest representation that reads back as the same value, integral
+ * values with a trailing ".0". Optionally numbers are rounded to a fixed
+ * number of decimals, e.g. 7 decimals are ~1 cm and shrink tile polygons by
+ * a fifth.
+ *
+ * The char buffer variants never allocate, the string variants append to the
+ * caller's string, so a reused string allocates only while it grows.
+ *
+ * FeatureCollectionWriter streams any number of features into a
+ * "FeatureCollection" through a fixed size buffer.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+//
+#include "nds/nds_status.h"
+#include "nds/nds_tile.h"
+#include "nds/nds_tile_set.h"
+#include "nds/wgs84_bbox.h"
+#include "nds/wgs84_coordinate.h"
+
+namespace nds {
+namespace geojson {
+
+/**
+ * Selects the shortest representation of numbers instead of fixed decimals.
+ */
+constexpr int kShortest = -1;
+/**
+ * The maximum number of decimals.
+ */
+constexpr int kMaxDecimals = 12;
+/**
+ * The maximum length of a formatted number, e.g. "-2.2250738585072014e-308"
+ * or "-123456789012345.123456789012".
+ */
+constexpr size_t kMaxNumberSize = 32;
+/**
+ * The maximum length of a "Point" feature.
+ */
+constexpr size_t kMaxPointSize = 96 + 2 * kMaxNumberSize;
+/**
+ * The maximum length of a "Polygon" feature.
+ */
+constexpr size_t kMaxPolygonSize = 96 + 5 * (2 * kMaxNumberSize + 4);
+
+/**
+ * Writes a number like the JSON serializer.
+ *
+ * @param value
+ *                a finite number
+ * @param out
+ *                room for kMaxNumberSize characters
+ * @param decimals
+ *                kShortest, or the number of decimals up to kMaxDecimals,
+ *                trailing zeros are dropped
+ * @return char* the end of the written text
+ */
+char *writeNumber(double value, char *out, int decimals = kShortest);
+
+/**
+ * Writes the "Point" feature of the coordinate, not null terminated.
+ *
+ * @param coord
+ * @param out
+ *                room for kMaxPointSize characters
+ * @param decimals
+ *                kShortest, or the number of decimals of the coordinates
+ * @return size_t the number of characters written
+ */
+size_t writePoint(const Wgs84Coordinate &coord, char *out,
+                  int decimals = kShortest);
+void writePoint(const Wgs84Coordinate &coord, std::string *out,
+                int decimals = kShortest);
+void writePoint(const Wgs84Coordinate &coord, std::ostream &out,
+                int decimals = kShortest);
+
+/**
+ * Writes the "Polygon" feature of the bounding box, starting at the south
+ * west corner counterclockwise, not null terminated.
+ *
+ * @param bbox
+ * @param out
+ *                room for kMaxPolygonSize characters
+ * @param decimals
+ *                kShortest, or the number of decimals of the coordinates
+ * @return size_t the number of characters written
+ */
+size_t writePolygon(const Wgs84Bbox &bbox, char *out,
+                    int decimals = kShortest);
+void writePolygon(const Wgs84Bbox &bbox, std::string *out,
+                  int decimals = kShortest);
+void writePolygon(const Wgs84Bbox &bbox, std::ostream &out,
+                  int decimals = kShortest);
+
+/**
+ * Writes the "Polygon" feature of the tile's bounding box, like
+ * NdsTile::toGeoJSON().
+ *
+ * @param tile
+ * @param out
+ *                room for kMaxPolygonSize characters
+ * @param decimals
+ *                kShortest, or the number of decimals of the coordinates
+ * @return size_t the number of characters written
+ */
+size_t writeTile(const NdsTile &tile, char *out, int decimals = kShortest);
+void writeTile(const NdsTile &tile, std::string *out,
+               int decimals = kShortest);
+void writeTile(const NdsTile &tile, std::ostream &out,
+               int decimals = kShortest);
+
+/**
+ * The properties of tile features, combined with |.
+ */
+enum TileProperties : int {
+  kNoProperties = 0,
+  kLevel = 1,
+  kTileNumber = 2,
+  kPackedId = 4,
+  kAllProperties = kLevel | kTileNumber | kPackedId
+};
+
+/**
+ * Writes a "FeatureCollection" to a stream with constant memory: features
+ * are formatted into a buffer, which is written to the stream whenever it
+ * holds chunkSize bytes. The collection is closed by finish() or the
+ * destructor.
+ *
+ * Features without properties are written like the toGeoJSON() methods, tile
+ * features get the selected TileProperties and an optional "count".
+ */
+class FeatureCollectionWriter {
+public:
+  static constexpr size_t kDefaultChunkSize = 1 << 16;
+
+  /**
+   * Starts the collection.
+   *
+   * @param out
+   *                the stream, must outlive the writer
+   * @param tileProperties
+   *                the TileProperties of tile features
+   * @param chunkSize
+   *                the number of bytes written to the stream at once
+   * @param decimals
+   *                kShortest, or the number of decimals of the coordinates
+   */
+  explicit FeatureCollectionWriter(std::ostream &out,
+                                   int tileProperties = kNoProperties,
+                                   size_t chunkSize = kDefaultChunkSize,
+                                   int decimals = kShortest);
+  ~FeatureCollectionWriter();
+  FeatureCollectionWriter(const FeatureCollectionWriter &) = delete;
+  FeatureCollectionWriter &operator=(const FeatureCollectionWriter &) = delete;
+
+  void add(const Wgs84Coordinate &coord);
+  void add(const Wgs84Bbox &bbox);
+  void add(const NdsTile &tile);
+  /**
+   * Adds a tile with a "count" property, e.g. the number of points within
+   * the tile.
+   *
+   * @param tile
+   * @param count
+   */
+  void add(const NdsTile &tile, int64_t count);
+  /**
+   * Adds the tiles of a range of tile numbers of the given level, e.g. of a
+   * tile cover.
+   *
+   * @param level
+   * @param range
+   */
+  void add(int level, const TileRange &range);
+  /**
+   * Adds the tiles of the set, level by level in Morton order.
+   *
+   * @param tiles
+   */
+  void add(const TileSet &tiles);
+  /**
+   * Adds all elements of an iterator range, e.g. of a container of
+   * coordinates, bounding boxes or tiles.
+   *
+   * @param first
+   * @param last
+   */
+  template <typename Iterator> void add(Iterator first, Iterator last) {
+    for (; first != last; ++first) {
+      add(*first);
+    }
+  }
+
+  /**
+   * The number of features added.
+   */
+  uint64_t size() const { return size_; }
+
+  /**
+   * Writes the buffered features to the stream and flushes it.
+   */
+  void flush();
+  /**
+   * Closes the collection and flushes the stream. Further features are
+   * ignored.
+   *
+   * @return Status kOk, or Status::kIoError if writing to the stream failed
+   */
+  Status finish();
+
+private:
+  /*
+   * Writes the buffer to the stream once it holds a chunk.
+   */
+  void writeChunk();
+  /*
+   * Makes room for one more feature and returns the write position.
+   */
+  char *beginFeature();
+  void endFeature(char *end);
+
+  std::ostream &out_;
+  int tileProperties_;
+  size_t chunkSize_;
+  int decimals_;
+  std::vector<char> buffer_;
+  size_t used_ = 0;
+  uint64_t size_ = 0;
+  bool finished_ = false;
+};
+
+} // namespace geojson
+} // namespace nds
@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * Morton code engine for NDS coordinates, according to the NDS Format
+ * Specification, Version 2.5.4, §7.2.1.
+ *
+ * The Morton code interleaves the bits of the longitude (even bit positions)
+ * and the 31-bit latitude (odd bit positions). Bit 62 carries the sign of the
+ * longitude and bit 61 the sign of the latitude, bit 63 is always zero.
+ *
+ * encode() / decode() pick the fastest implementation available on the
+ * running CPU once at startup: PDEP/PEXT on BMI2-capable x86 CPUs, otherwise
+ * a branch-free magic-number bit spreading. All implementations produce
+ * bit-identical results to the reference loop.
+ */
+#include <cstdint>
+
+/*
+ * True during constant evaluation. The constexpr wrappers around the Morton
+ * engine use the portable implementation at compile time and the runtime
+ * dispatched one otherwise.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define NDS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define NDS_CONSTANT_EVALUATED() true
+#endif
+
+namespace nds {
+namespace morton {
+
+/**
+ * Spreads the 32 bits of value to the even bit positions of a 64-bit word.
+ */
+constexpr uint64_t spreadBits(uint32_t value) {
+  uint64_t x = value;
+  x = (x | x << 16) & 0x0000FFFF0000FFFFULL;
+  x = (x | x << 8) & 0x00FF00FF00FF00FFULL;
+  x = (x | x << 4) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | x << 2) & 0x3333333333333333ULL;
+  x = (x | x << 1) & 0x5555555555555555ULL;
+  return x;
+}
+
+/**
+ * Gathers the even bit positions of a 64-bit word into 32 bits, the inverse of
+ * spreadBits().
+ */
+constexpr uint32_t compactBits(uint64_t value) {
+  uint64_t x = value & 0x5555555555555555ULL;
+  x = (x | x >> 1) & 0x3333333333333333ULL;
+  x = (x | x >> 2) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | x >> 4) & 0x00FF00FF00FF00FFULL;
+  x = (x | x >> 8) & 0x0000FFFF0000FFFFULL;
+  x = (x | x >> 16) & 0x00000000FFFFFFFFULL;
+  return (uint32_t)x;
+}
+
+/**
+ * Branch-free Morton encoding using magic-number bit spreading.
+ *
+ * @param longitude
+ * @param latitude
+ * @return int64_t
+ */
+constexpr int64_t encodePortable(int32_t longitude, int32_t latitude) {
+  uint64_t res = spreadBits((uint32_t)longitude) |
+                 spreadBits((uint32_t)latitude & 0x7FFFFFFFu) << 1;
+  // Bit 62 is set by the longitude sign bit, the latitude sign is copied to
+  // bit 61.
+  if (latitude < 0) {
+    res |= 1ULL << 61;
+  }
+  return (int64_t)res;
+}
+
+/**
+ * Branch-free Morton decoding using magic-number bit compaction.
+ *
+ * @param code
+ * @param longitude
+ * @param latitude
+ */
+constexpr void decodePortable(int64_t code, int32_t *longitude,
+                              int32_t *latitude) {
+  uint32_t lat = compactBits((uint64_t)code >> 1) & 0x7FFFFFFFu;
+  // The latitude is a 31-bit signed integer, extend bit 30 into bit 31.
+  lat |= (lat & 0x40000000u) << 1;
+  *longitude = (int32_t)compactBits((uint64_t)code);
+  *latitude = (int32_t)lat;
+}
+
+/**
+ * Bit-by-bit reference implementation, kept as the specification of the
+ * encoding. Use encode() in production code.
+ */
+int64_t encodeReference(int32_t longitude, int32_t latitude);
+void decodeReference(int64_t code, int32_t *longitude, int32_t *latitude);
+
+/**
+ * PDEP/PEXT implementation. Must only be called if bmi2Supported() is true.
+ */
+int64_t encodeBmi2(int32_t longitude, int32_t latitude);
+void decodeBmi2(int64_t code, int32_t *longitude, int32_t *latitude);
+
+/**
+ * Checks if the PDEP/PEXT implementation is available and used by encode()
+ * and decode() on this CPU.
+ *
+ * @return bool
+ */
+bool bmi2Supported();
+
+/**
+ * Returns the Morton code of a NDS coordinate using the fastest available
+ * implementation.
+ *
+ * @param longitude
+ * @param latitude
+ * @return int64_t
+ */
+int64_t encode(int32_t longitude, int32_t latitude);
+
+/**
+ * Splits a Morton code into NDS longitude and latitude using the fastest
+ * available implementation.
+ *
+ * @param code
+ * @param longitude
+ * @param latitude
+ */
+void decode(int64_t code, int32_t *longitude, int32_t *latitude);
+
+} // namespace morton
+} // namespace nds
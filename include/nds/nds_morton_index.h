@@ -0,0 +1,120 @@
+#pragma once
+
+/**
+ * Morton index: a read-only spatial index over point records.
+ *
+ * The records are sorted by the Morton code of their coordinate, so the
+ * records of a tile are consecutive and are found by two binary searches. A
+ * bounding box is decomposed into the Morton ranges of the tiles covering it.
+ * Codes and payloads are stored in separate flat arrays, the searches only
+ * touch the codes.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+//
+#include "nds/nds_bbox.h"
+#include "nds/nds_tile.h"
+
+namespace nds {
+
+/**
+ * A point record: the Morton code of its NDS coordinate and an opaque
+ * payload, e.g. the offset of the full record in a file.
+ */
+struct MortonRecord {
+  int64_t morton;
+  uint64_t payload;
+};
+
+/**
+ * A half-open range [first, last) of record positions within a MortonIndex.
+ */
+struct IndexRange {
+  size_t first;
+  size_t last;
+
+  size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+};
+
+class MortonIndex {
+public:
+  MortonIndex() = default;
+  /**
+   * Builds the index from records in any order. Records with equal Morton
+   * codes keep their relative order.
+   *
+   * @param records
+   */
+  explicit MortonIndex(std::vector<MortonRecord> records);
+  /**
+   * Builds the index from arrays of NDS coordinates and payloads. The Morton
+   * codes are computed with the batch kernels, see encodeMortonCodes().
+   *
+   * @param ndsLon
+   *                the NDS longitudes
+   * @param ndsLat
+   *                the NDS latitudes
+   * @param payloads
+   *                the payloads
+   * @param count
+   *                the number of records
+   */
+  MortonIndex(const int32_t *ndsLon, const int32_t *ndsLat,
+              const uint64_t *payloads, size_t count);
+
+  size_t size() const { return codes_.size(); }
+  bool empty() const { return codes_.empty(); }
+  int64_t morton(size_t i) const { return codes_[i]; }
+  uint64_t payload(size_t i) const { return payloads_[i]; }
+  NdsCoordinate coordinate(size_t i) const { return NdsCoordinate(codes_[i]); }
+
+  /**
+   * Returns the records with a Morton code in [firstMorton, lastMorton].
+   *
+   * @param firstMorton
+   * @param lastMorton
+   * @return IndexRange
+   */
+  IndexRange find(int64_t firstMorton, int64_t lastMorton) const;
+  /**
+   * Returns the records within a tile, which are consecutive.
+   *
+   * @param tile
+   * @return IndexRange
+   */
+  IndexRange find(const NdsTile &tile) const;
+  /**
+   * Returns the records within the tiles covering the bounding box, sorted
+   * and disjoint. The tile level is chosen so that about 5 x 5 tiles cover
+   * the box. The ranges may contain records outside of the box.
+   *
+   * @param bbox
+   *                the inclusive bounding box, west > east crosses the
+   *                antimeridian
+   * @return std::vector<IndexRange>
+   */
+  std::vector<IndexRange> candidates(const NdsBbox &bbox) const;
+  /**
+   * Returns the positions of the records within the bounding box, in Morton
+   * order.
+   *
+   * @param bbox
+   *                the inclusive bounding box, west > east crosses the
+   *                antimeridian
+   * @return std::vector<size_t>
+   */
+  std::vector<size_t> query(const NdsBbox &bbox) const;
+
+private:
+  void build(std::vector<MortonRecord> *records);
+
+  /*
+   * The sorted Morton codes and the payloads in the same order.
+   */
+  std::vector<int64_t> codes_;
+  std::vector<uint64_t> payloads_;
+};
+
+} // namespace nds
@@ -0,0 +1,128 @@
+#pragma once
+
+/**
+ * Compressed streams of Morton sorted coordinates.
+ *
+ * Consecutive Morton codes of sorted points, e.g. of probe traces, differ by
+ * small amounts. The stream stores the differences as LEB128 varints, 7 bits
+ * per byte, in blocks of kBlockSize codes. The first code of every block is
+ * kept uncompressed as a block index, so the codes of a tile are found by a
+ * binary search over the blocks and decoding only the blocks overlapping the
+ * tile.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+//
+#include "nds/nds_coordinate.h"
+#include "nds/nds_status.h"
+#include "nds/nds_tile.h"
+
+namespace nds {
+
+class MortonStream {
+public:
+  /**
+   * The number of codes per block, a trade-off between the size of the
+   * block index and the codes decoded in vain by random access.
+   */
+  static constexpr size_t kBlockSize = 128;
+
+  MortonStream() = default;
+  /**
+   * Encodes the Morton codes of the coordinates, in any order.
+   *
+   * @param coords
+   */
+  explicit MortonStream(const std::vector<NdsCoordinate> &coords);
+  /**
+   * Encodes ascending Morton codes, duplicates are allowed.
+   *
+   * @param codes
+   * @param count
+   */
+  MortonStream(const int64_t *codes, size_t count);
+
+  /**
+   * The number of codes.
+   */
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t blockCount() const { return firsts_.size(); }
+  /**
+   * The number of bytes of the compressed codes and the block index, as
+   * written by serialize() without the header.
+   */
+  size_t byteSize() const {
+    size_t deltas = offsets_.empty() ? 0 : offsets_.back();
+    return deltas + firsts_.size() * (sizeof(int64_t) + 4);
+  }
+
+  /**
+   * Decodes one block.
+   *
+   * @param block
+   * @param out
+   *                room for kBlockSize codes
+   * @return size_t the number of codes of the block
+   */
+  size_t decodeBlock(size_t block, int64_t *out) const;
+  /**
+   * Appends all codes in ascending order.
+   *
+   * @param out
+   */
+  void decode(std::vector<int64_t> *out) const;
+  void decode(std::vector<NdsCoordinate> *out) const;
+
+  /**
+   * Appends the codes in [firstMorton, lastMorton].
+   *
+   * @param firstMorton
+   * @param lastMorton
+   * @param out
+   */
+  void find(int64_t firstMorton, int64_t lastMorton,
+            std::vector<int64_t> *out) const;
+  /**
+   * Appends the coordinates within the tile, in Morton order.
+   *
+   * @param tile
+   * @param out
+   */
+  void find(const NdsTile &tile, std::vector<NdsCoordinate> *out) const;
+
+  /**
+   * Appends the binary representation of the stream: the magic "NDMS", the
+   * number of codes as u64 and for each block the first code as u64, the
+   * number of delta bytes as u32 and the varint deltas of the other codes.
+   * All fixed width numbers are little endian.
+   *
+   * @param out
+   */
+  void serialize(std::vector<uint8_t> *out) const;
+  /**
+   * Reads a stream written by serialize().
+   *
+   * @param data
+   * @param size
+   * @return Result<MortonStream> the stream, or Status::kInvalidData if the
+   *         data is truncated or malformed
+   */
+  static Result<MortonStream> deserialize(const uint8_t *data, size_t size);
+
+private:
+  void encode(const int64_t *codes, size_t count);
+
+  /*
+   * The first code of each block, and the offsets of the delta bytes of each
+   * block in bytes_, with the end of the last block as extra element. The
+   * bytes are followed by zero padding.
+   */
+  std::vector<int64_t> firsts_;
+  std::vector<size_t> offsets_;
+  std::vector<uint8_t> bytes_;
+  size_t size_ = 0;
+};
+
+} // namespace nds
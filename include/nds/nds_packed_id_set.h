@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ * Packed ID set: a read-only set of packed Tile IDs for fast membership
+ * tests on large sets.
+ *
+ * The IDs are stored in Eytzinger (breadth-first search tree) order: the
+ * children of position k are at 2k and 2k+1. The first levels of the tree
+ * share a few cache lines, and the search is branchless and prefetches the
+ * cache line holding the 16 descendants four levels down, so memory latency
+ * overlaps with the comparisons instead of stalling every step like a binary
+ * search over a sorted array.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+//
+#include "nds/nds_tile.h"
+
+namespace nds {
+
+class PackedIdSet {
+public:
+  PackedIdSet() = default;
+  /**
+   * Builds the set from packed Tile IDs in any order, duplicates are
+   * dropped.
+   *
+   * @param packedIds
+   */
+  explicit PackedIdSet(std::vector<int> packedIds);
+  /**
+   * Builds the set from the packed IDs of the tiles.
+   *
+   * @param tiles
+   */
+  explicit PackedIdSet(const std::vector<NdsTile> &tiles);
+
+  /**
+   * The number of distinct IDs.
+   */
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * Checks if the set contains the packed Tile ID.
+   *
+   * @param packedId
+   * @return true, if the ID is contained
+   */
+  bool contains(int packedId) const;
+  bool contains(const NdsTile &tile) const {
+    return contains(tile.packedId());
+  }
+
+  /**
+   * Returns the IDs in ascending order.
+   *
+   * @return std::vector<int>
+   */
+  std::vector<int> sorted() const;
+
+private:
+  /*
+   * 16 IDs fill one cache line. The tree starts at index 1, so the 16
+   * descendants of k four levels down, 16k .. 16k+15, share a cache line.
+   */
+  struct alignas(64) Block {
+    int32_t ids[16];
+  };
+
+  const int32_t *tree() const { return blocks_.front().ids; }
+  void build(std::vector<int> *packedIds);
+
+  size_t size_ = 0;
+  std::vector<Block> blocks_;
+};
+
+} // namespace nds
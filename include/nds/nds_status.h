@@ -0,0 +1,75 @@
+#pragma once
+#include <optional>
+#include <utility>
+
+namespace nds {
+/**
+ * Validation result of the non-fatal factory functions, e.g.
+ * NdsCoordinate::create().
+ */
+enum class Status {
+  kOk = 0,
+  kInvalidLongitude,
+  kInvalidLatitude,
+  kInvalidLevel,
+  kInvalidTileNumber,
+  kInvalidPackedId,
+  kInvalidData,
+  kIoError
+};
+
+/**
+ * Returns a static description of the status, no allocation takes place.
+ *
+ * @param status
+ * @return const char*
+ */
+inline const char *statusMessage(Status status) {
+  switch (status) {
+  case Status::kOk:
+    return "OK";
+  case Status::kInvalidLongitude:
+    return "longitude exceeds the valid range";
+  case Status::kInvalidLatitude:
+    return "latitude exceeds the valid range";
+  case Status::kInvalidLevel:
+    return "tile level exceeds the range [0, 15]";
+  case Status::kInvalidTileNumber:
+    return "tile number is not admissible for the tile level";
+  case Status::kInvalidPackedId:
+    return "packed tile ID has no level bit";
+  case Status::kInvalidData:
+    return "serialized data is truncated or malformed";
+  case Status::kIoError:
+    return "reading or writing the stream failed";
+  }
+  return "unknown status";
+}
+
+/**
+ * Either a valid value or the Status describing why it could not be created.
+ * Never allocates and never logs, so it can be used to drop or count invalid
+ * records inside tight loops.
+ */
+template <typename T> class Result {
+public:
+  Result(T value) : status_(Status::kOk), value_(std::move(value)) {}
+  Result(Status status) : status_(status) {}
+
+  bool ok() const { return status_ == Status::kOk; }
+  explicit operator bool() const { return ok(); }
+  Status status() const { return status_; }
+
+  /**
+   * Returns the value. Must only be called if ok() is true.
+   *
+   * @return const T&
+   */
+  const T &value() const { return *value_; }
+  T &value() { return *value_; }
+
+private:
+  Status status_;
+  std::optional<T> value_;
+};
+} // namespace nds
@@ -1,12 +1,87 @@
 #pragma once
 #include "nds/nds_bbox.h"
 #include "nds/nds_coordinate.h"
+#include <array>
+#include <type_traits>
 
 namespace nds {
 /**
  * The maximum Tile level within the NDS specification.
  */
 constexpr int kMaxLevel = 15;
+
+/**
+ * The longitude extent of a tile of the given level (1..15) in NDS coordinate
+ * units, the level 0 tiles are a hemisphere wide.
+ *
+ * @param level
+ * @return int
+ */
+constexpr int tileWidth(int level) {
+  return (int)(kLongitudeRange >> (level + 1));
+}
+
+/**
+ * The latitude extent of a tile of the given level (1..15) in NDS coordinate
+ * units.
+ *
+ * @param level
+ * @return int
+ */
+constexpr int tileHeight(int level) { return (int)(kLatitudeRange >> level); }
+
+/**
+ * The bit marking the level within a packed Tile ID. For level 15 it is the
+ * sign bit.
+ *
+ * @param level
+ * @return int
+ */
+constexpr int levelBit(int level) { return (int)(1u << (16 + level)); }
+
+/**
+ * The number of low Morton code bits dropped to obtain a tile number of the
+ * given level.
+ *
+ * @param level
+ * @return int
+ */
+constexpr int mortonShift(int level) { return 32 + (kMaxLevel - level) * 2; }
+
+/**
+ * Counts the leading zero bits of a non-zero 32-bit value.
+ *
+ * @param value
+ * @return int
+ */
+constexpr int countLeadingZeros(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clz(value);
+#else
+  int n = 0;
+  for (uint32_t bit = 1u << 31; (value & bit) == 0; bit >>= 1) {
+    n++;
+  }
+  return n;
+#endif
+}
+
+/**
+ * An inclusive range of tile numbers of one level.
+ */
+struct TileRange {
+  int first;
+  int last;
+
+  /**
+   * The number of tiles within the range.
+   */
+  constexpr int64_t size() const { return (int64_t)last - first + 1; }
+  constexpr bool operator==(const TileRange &other) const {
+    return first == other.first && last == other.last;
+  }
+};
+
 class NdsTile {
 public:
   /**
@@ -15,7 +90,13 @@ public:
    * @param packedId
    * @see NDSSpecification 2.5.4: 7.3.3 Generating Packed Tile IDs
    */
-  NdsTile(int packedId);
+  constexpr NdsTile(int packedId)
+      : level_(extractLevel(packedId)),
+        tileNumber_(packedId ^ levelBit(level_)) {
+    if (level_ < 0) {
+      verifyPackedId(packedId);
+    }
+  }
   /**
    * Creates a new {@link NdsTile} instance for a given id and level.
    *
@@ -26,7 +107,11 @@ public:
    *
    * @see NDSSpecification 2.5.4: 7.3.3 Generating Packed Tile IDs
    */
-  NdsTile(int level, int nr);
+  constexpr NdsTile(int level, int nr) : level_(level), tileNumber_(nr) {
+    if (level < 0 || nr < 0 || nr > (1L << (2 * level + 1)) - 1) {
+      verify(level, nr);
+    }
+  }
   /**
    *
    * Creates a new {@link NdsTile} instance of the specified level, containing
@@ -35,7 +120,14 @@ public:
    * @param level
    * @param coord
    */
-  NdsTile(int level, NdsCoordinate coord);
+  constexpr NdsTile(int level, NdsCoordinate coord)
+      /*
+       * Getting the NDS tile for a NDS coordinate amount to shifting the
+       * morton code of the coordinate by the necessary amount. Each NdsTile
+       * can be represented by the level and morton code of the lower left /
+       * south west corner.
+       */
+      : NdsTile(level, (int)(coord.getMortonCode() >> mortonShift(level))) {}
   /**
    * Creates a new {@link NdsTile} instance of the specified level, containing
    * the specified coordinate
@@ -46,6 +138,38 @@ public:
    *                  the coord
    */
   NdsTile(int level, Wgs84Coordinate coord);
+
+  /**
+   * Creates a new {@link NdsTile} instance from a packed Tile id without
+   * aborting or logging on invalid input.
+   *
+   * @param packedId
+   * @return Result<NdsTile> the tile, or Status::kInvalidPackedId
+   */
+  static Result<NdsTile> fromPackedId(int packedId);
+  /**
+   * Creates a new {@link NdsTile} instance for a given id and level without
+   * aborting on invalid input.
+   *
+   * @param level
+   *                  Must be in range 0..15
+   * @param nr
+   *                  An admissible tile number w.r.t to the specified level.
+   * @return Result<NdsTile> the tile, or Status::kInvalidLevel /
+   *         Status::kInvalidTileNumber
+   */
+  static Result<NdsTile> create(int level, int nr);
+  /**
+   * Creates a new {@link NdsTile} instance of the specified level, containing
+   * the specified coordinate, without aborting on invalid input.
+   *
+   * @param level
+   *                  Must be in range 0..15
+   * @param coord
+   * @return Result<NdsTile> the tile, or Status::kInvalidLevel
+   */
+  static Result<NdsTile> create(int level, NdsCoordinate coord);
+  static Result<NdsTile> create(int level, Wgs84Coordinate coord);
   /**
    * Checks if the current Tile contains a certain coordinate.
    *
@@ -53,7 +177,7 @@ public:
    *              the coordinate
    * @return true, if successful
    */
-  bool contains(NdsCoordinate c) {
+  constexpr bool contains(NdsCoordinate c) const {
     /*
      * Checks containment via verifying if the coordinates' tile number for the
      * current tile level matches.
@@ -61,8 +185,7 @@ public:
      * The tile number is identical to the (2*level+1) most-significant bits of
      * the Morton code of the south-west corner of the tile.
      */
-    return tileNumber_ ==
-           (int)(c.getMortonCode() >> 32 + (kMaxLevel - level_) * 2);
+    return tileNumber_ == (int)(c.getMortonCode() >> mortonShift(level_));
   }
 
   /**
@@ -73,17 +196,28 @@ public:
    *
    * @return
    */
-  int packedId() { return tileNumber_ + (1L << (16 + level_)); }
-  ~NdsTile() {
-    if (center_ != nullptr)
-      delete center_;
+  constexpr int packedId() const {
+    return (int)((unsigned)tileNumber_ + (unsigned)levelBit(level_));
   }
   /**
-   * Returns the center of this tile as NdsCoordinate
+   * Returns the center of this tile as NdsCoordinate. The center is computed
+   * on demand, cache it on the caller side if needed.
    *
    * @return NdsCoordinate The center of this tile
    */
-  NdsCoordinate getCenter();
+  constexpr NdsCoordinate getCenter() const {
+    if (level_ == 0) {
+      return tileNumber_ == 0 ? NdsCoordinate(kMaxLongitude / 2, 0)
+                              : NdsCoordinate(kMinLongitude / 2, 0);
+    }
+    NdsCoordinate sw(southWestAsMorton());
+    // Same computation as for bounding box, but for the next lower level
+    int clat = sw.latitude() + tileHeight(level_ + 1) +
+               (sw.latitude() < 0 ? 1 : 0);
+    int clon = sw.longitude() + tileWidth(level_ + 1) +
+               (sw.longitude() < 0 ? 1 : 0);
+    return NdsCoordinate(clon, clat);
+  }
   /**
    * Creates a bounding box for the current tile.
    *
@@ -91,41 +225,277 @@ public:
    *
    * @return
    */
-  NdsBbox getBBox();
+  constexpr NdsBbox getBBox() const {
+    /*
+     * For level 0 there are two tiles.
+     */
+    if (level_ == 0) {
+      return tileNumber_ == 0 ? NdsBbox::EAST_HEMISPHERE()
+                              : NdsBbox::WEST_HEMISPHERE();
+    }
+    NdsCoordinate sw(southWestAsMorton());
+    int north =
+        sw.latitude() + tileHeight(level_) + (sw.latitude() < 0 ? 1 : 0);
+    int east =
+        sw.longitude() + tileWidth(level_) + (sw.longitude() < 0 ? 1 : 0);
+    return NdsBbox(north, east, sw.latitude(), sw.longitude());
+  }
   /**
    * Computes a GeoJSON representation of the NDS Tile as GeoJSON "Polygon"
    * feature.
    *
    * @return String
    */
-  std::string toGeoJSON() { return getBBox().toWGS84().toGeoJSON(); }
-
-  long southWestAsMorton() {
-    int shift = 32 + (kMaxLevel - level_) * 2;
-    return (long)tileNumber_ << shift;
-  }
-  int extractLevel(int packedId) {
-    for (int lvl = kMaxLevel; lvl > -1; lvl--) {
-      int lvl_bit = 1 << 16 + lvl;
-      if ((packedId & lvl_bit) > 0) {
-        return lvl;
-      }
-      // The 32nd bit can not be checked by java's native integer, as the sign
-      // bit is hidden
-      if (packedId < 0 && lvl == kMaxLevel)
-        return kMaxLevel;
+  std::string toGeoJSON() const { return getBBox().toWGS84().toGeoJSON(); }
+
+  constexpr long southWestAsMorton() const {
+    return (long)tileNumber_ << mortonShift(level_);
+  }
+  /**
+   * Returns the level of a packed Tile ID, i.e. the position of its highest
+   * bit above bit 16, or -1 if no level bit is present. Negative IDs are on
+   * level 15, the level bit is the sign bit.
+   *
+   * @param packedId
+   * @return int
+   */
+  static constexpr int extractLevel(int packedId) {
+    // Setting bit 15 maps IDs without level bit to -1 without a branch.
+    return 15 - countLeadingZeros((unsigned)packedId | 0x8000u);
+  }
+
+  /**
+   * Returns the tile of the next lower level containing this tile. Level 0
+   * tiles have no parent.
+   *
+   * @return NdsTile
+   */
+  constexpr NdsTile parent() const { return ancestor(level_ - 1); }
+  /**
+   * Returns the tile of the given lower (or the same) level containing this
+   * tile, by dropping two tile number bits per level.
+   *
+   * @param level
+   *                  Must be in range 0..level()
+   * @return NdsTile
+   */
+  constexpr NdsTile ancestor(int level) const {
+    if (level < 0 || level > level_) {
+      verifyRelativeLevel(level_, level);
+    }
+    return NdsTile(level, tileNumber_ >> 2 * (level_ - level));
+  }
+  /**
+   * Returns one of the four tiles of the next higher level within this tile.
+   * Bit 0 of the index selects the eastern, bit 1 the northern half, i.e.
+   * the children in Morton order are south west, south east, north west and
+   * north east.
+   *
+   * @param index
+   *                  Must be in range 0..3
+   * @return NdsTile
+   */
+  constexpr NdsTile child(int index) const {
+    if (level_ >= kMaxLevel || index < 0 || index > 3) {
+      verifyRelativeLevel(level_, index < 0 || index > 3 ? -1 : level_ + 1);
     }
-    return -1;
+    return NdsTile(level_ + 1, tileNumber_ << 2 | index);
+  }
+  /**
+   * Returns the four tiles of the next higher level within this tile, in
+   * Morton order.
+   *
+   * @return std::array<NdsTile, 4>
+   */
+  constexpr std::array<NdsTile, 4> children() const {
+    return {child(0), child(1), child(2), child(3)};
+  }
+  /**
+   * Returns the four children of the parent, i.e. this tile and its three
+   * siblings, in Morton order. Level 0 tiles have no parent.
+   *
+   * @return std::array<NdsTile, 4>
+   */
+  constexpr std::array<NdsTile, 4> siblings() const {
+    return parent().children();
+  }
+  /**
+   * Returns the tiles of the given higher (or the same) level within this
+   * tile. They are consecutive in Morton order.
+   *
+   * @param level
+   *                  Must be in range level()..15
+   * @return TileRange the tile numbers of the given level
+   */
+  constexpr TileRange descendants(int level) const {
+    if (level < level_ || level > kMaxLevel) {
+      verifyRelativeLevel(level_, level);
+    }
+    int shift = 2 * (level - level_);
+    return {tileNumber_ << shift,
+            (int)((((int64_t)tileNumber_ + 1) << shift) - 1)};
+  }
+  /**
+   * Returns the highest level of a tile containing both tiles, or -1 if they
+   * lie in different level 0 tiles (hemispheres). Use ancestor() of either
+   * tile to obtain the common ancestor.
+   *
+   * @param a
+   * @param b
+   * @return int
+   */
+  static constexpr int commonAncestorLevel(const NdsTile &a,
+                                           const NdsTile &b) {
+    int level = a.level_ < b.level_ ? a.level_ : b.level_;
+    uint32_t diff = (uint32_t)(a.tileNumber_ >> 2 * (a.level_ - level)) ^
+                    (uint32_t)(b.tileNumber_ >> 2 * (b.level_ - level));
+    if (diff == 0) {
+      return level;
+    }
+    // Drop levels until the highest differing bit is gone.
+    return level - (31 - countLeadingZeros(diff)) / 2 - 1;
+  }
+
+  /**
+   * Returns the neighboring tile of the same level to the east, wrapping
+   * around at the antimeridian. The column is incremented directly within
+   * the interleaved tile number.
+   *
+   * @return NdsTile
+   */
+  constexpr NdsTile east() const {
+    uint32_t x = ((uint32_t)tileNumber_ | ~columnMask()) + 1;
+    return withColumn(x);
+  }
+  /**
+   * Returns the neighboring tile of the same level to the west, wrapping
+   * around at the antimeridian.
+   *
+   * @return NdsTile
+   */
+  constexpr NdsTile west() const {
+    uint32_t x = ((uint32_t)tileNumber_ & columnMask()) - 1;
+    return withColumn(x);
+  }
+  /**
+   * Checks if there is a tile of the same level to the north, i.e. the tile
+   * does not touch the north pole. Level 0 tiles span both poles.
+   *
+   * @return true, if a northern neighbor exists
+   */
+  constexpr bool hasNorth() const {
+    // The northernmost row is the largest signed row, 0b0111...1.
+    return level_ > 0 &&
+           ((uint32_t)tileNumber_ & rowMask()) != (rowMask() & ~topRowBit());
+  }
+  /**
+   * Checks if there is a tile of the same level to the south, i.e. the tile
+   * does not touch the south pole.
+   *
+   * @return true, if a southern neighbor exists
+   */
+  constexpr bool hasSouth() const {
+    // The southernmost row is the smallest signed row, 0b1000...0.
+    return level_ > 0 && ((uint32_t)tileNumber_ & rowMask()) != topRowBit();
+  }
+  /**
+   * Returns the neighboring tile of the same level to the north. At the north
+   * pole the row is clamped, i.e. the tile itself is returned.
+   *
+   * @return NdsTile
+   */
+  constexpr NdsTile north() const {
+    if (!hasNorth()) {
+      return *this;
+    }
+    uint32_t y = ((uint32_t)tileNumber_ | ~rowMask()) + 2;
+    return withRow(y);
+  }
+  /**
+   * Returns the neighboring tile of the same level to the south. At the south
+   * pole the row is clamped, i.e. the tile itself is returned.
+   *
+   * @return NdsTile
+   */
+  constexpr NdsTile south() const {
+    if (!hasSouth()) {
+      return *this;
+    }
+    uint32_t y = ((uint32_t)tileNumber_ & rowMask()) - 2;
+    return withRow(y);
+  }
+  /**
+   * Returns the four edge neighbors in the order east, north, west, south.
+   * Rows are clamped at the poles, see north() and south().
+   *
+   * @return std::array<NdsTile, 4>
+   */
+  constexpr std::array<NdsTile, 4> edgeNeighbors() const {
+    return {east(), north(), west(), south()};
+  }
+  /**
+   * Returns the 3x3 window of tiles around and including this tile, row by
+   * row from south west to north east. Columns wrap around at the
+   * antimeridian, rows are clamped at the poles, so tiles at the poles
+   * appear repeatedly.
+   *
+   * @return std::array<NdsTile, 9>
+   */
+  constexpr std::array<NdsTile, 9> window() const {
+    NdsTile s = south(), n = north();
+    return {s.west(), s, s.east(), west(), *this,
+            east(),   n.west(), n, n.east()};
   }
 
-  int level() const { return level_; }
-  int tileNumber() const { return tileNumber_; }
-  bool operator==(const NdsTile &other) {
+  constexpr int level() const { return level_; }
+  constexpr int tileNumber() const { return tileNumber_; }
+  constexpr bool operator==(const NdsTile &other) const {
     return this->level_ == other.level_ &&
            this->tileNumber_ == other.tileNumber_;
   }
 
 private:
+  constexpr NdsTile() = default;
+
+  /*
+   * Log the error for an invalid level / tile number or packed Tile ID.
+   */
+  static void verify(int level, int nr);
+  static void verifyPackedId(int packedId);
+  /*
+   * Log the error for a parent, child or descendant level out of range.
+   */
+  static void verifyRelativeLevel(int level, int relativeLevel);
+
+  /*
+   * The column bits (even positions) and row bits (odd positions) of the
+   * tile numbers of this level.
+   */
+  constexpr uint32_t columnMask() const {
+    return (uint32_t)(((uint64_t)1 << (2 * level_ + 1)) - 1) & 0x55555555u;
+  }
+  constexpr uint32_t rowMask() const {
+    return (uint32_t)(((uint64_t)1 << (2 * level_ + 1)) - 1) & 0xAAAAAAAAu;
+  }
+  /*
+   * The sign bit of the row, zero for level 0.
+   */
+  constexpr uint32_t topRowBit() const {
+    return level_ == 0 ? 0 : 1u << (2 * level_ - 1);
+  }
+  /*
+   * Replaces the column / row bits by the masked bits of x / y. Carries and
+   * borrows beyond the top bit drop out, which wraps the column around.
+   */
+  constexpr NdsTile withColumn(uint32_t x) const {
+    return NdsTile(level_, (int)((x & columnMask()) |
+                                 ((uint32_t)tileNumber_ & rowMask())));
+  }
+  constexpr NdsTile withRow(uint32_t y) const {
+    return NdsTile(level_, (int)((y & rowMask()) |
+                                 ((uint32_t)tileNumber_ & columnMask())));
+  }
+
   /*
    * The tile level
    */
@@ -137,13 +507,15 @@ private:
    * The tile number is identical to the (2*level+1) most-significant bits of
    * the Morton code of the south-west corner of the tile.
    */
-  int tileNumber_;
-
-  /*
-   * Transient center coordinate
-   */
-  NdsCoordinate *center_ = nullptr;
+  int tileNumber_ = 0;
 };
+/*
+ * NdsTile is a plain 8 byte value, so large tile vectors can be stored flat
+ * and copied with memcpy.
+ */
+static_assert(std::is_trivially_copyable<NdsTile>::value,
+              "NdsTile must be trivially copyable");
+static_assert(sizeof(NdsTile) == 8, "NdsTile must consist of level and number");
 inline std::ostream &operator<<(std::ostream &out, const NdsTile &other) {
   out << "level: " << other.level() << " , tileNumber: " << other.tileNumber();
   return out;
@@ -0,0 +1,161 @@
+#pragma once
+
+/**
+ * Tile cover: enumerates the tiles of a level which intersect an area.
+ *
+ * The tiles are generated in Morton order as ranges of consecutive tile
+ * numbers. A range is emitted as soon as a quadtree cell lies completely
+ * inside the area, so the work is proportional to the boundary of the area
+ * and not to the number of tiles.
+ */
+#include <cstdint>
+#include <vector>
+//
+#include "nds/nds_bbox.h"
+#include "nds/nds_tile.h"
+#include "nds/wgs84_bbox.h"
+
+namespace nds {
+
+/**
+ * Computes the tiles of the given level intersecting the bounding box, as
+ * sorted, disjoint and non-adjacent ranges of tile numbers.
+ *
+ * The bounding box is inclusive. If west is greater than east, the box
+ * crosses the antimeridian. A box with south greater than north is empty.
+ *
+ * @param bbox
+ *                the bounding box
+ * @param level
+ *                the tile level, must be in range 0..15
+ * @return std::vector<TileRange>
+ */
+std::vector<TileRange> coverRanges(const NdsBbox &bbox, int level);
+std::vector<TileRange> coverRanges(const Wgs84Bbox &bbox, int level);
+
+/**
+ * Computes the tiles of the given level intersecting the bounding box, in
+ * Morton order.
+ *
+ * @param bbox
+ * @param level
+ * @return std::vector<NdsTile>
+ */
+std::vector<NdsTile> coverTiles(const NdsBbox &bbox, int level);
+std::vector<NdsTile> coverTiles(const Wgs84Bbox &bbox, int level);
+
+/**
+ * Computes the packed IDs of the tiles of the given level intersecting the
+ * bounding box, in Morton order.
+ *
+ * @param bbox
+ * @param level
+ * @return std::vector<int>
+ */
+std::vector<int> coverPackedIds(const NdsBbox &bbox, int level);
+std::vector<int> coverPackedIds(const Wgs84Bbox &bbox, int level);
+
+/**
+ * Expands tile ranges of the given level to tiles.
+ *
+ * @param ranges
+ * @param level
+ * @return std::vector<NdsTile>
+ */
+std::vector<NdsTile> toTiles(const std::vector<TileRange> &ranges, int level);
+
+/**
+ * The tiles of one level covering a polygon, split into the tiles lying
+ * completely inside the polygon and the tiles intersecting its boundary.
+ */
+struct PolygonCover {
+  std::vector<TileRange> interior;
+  std::vector<TileRange> boundary;
+};
+
+/**
+ * Computes the tiles of the given level covering a polygon.
+ *
+ * The polygon is given as rings of vertices; the first ring is the outer
+ * ring, the others are holes. The rings are closed implicitly. Inside is
+ * defined by the even-odd rule, so the orientation of the rings does not
+ * matter. Edges are straight lines in NDS coordinates and must not cross
+ * the antimeridian.
+ *
+ * The tiles are classified hierarchically from level 0 on: quadrants which
+ * do not intersect any edge are emitted as a whole without descending.
+ *
+ * @param rings
+ *                the polygon rings
+ * @param level
+ *                the tile level, must be in range 0..15
+ * @return PolygonCover
+ */
+PolygonCover coverPolygon(const std::vector<std::vector<NdsCoordinate>> &rings,
+                          int level);
+PolygonCover
+coverPolygon(const std::vector<std::vector<Wgs84Coordinate>> &rings,
+             int level);
+
+/**
+ * Computes the tiles of the given level a polyline passes through, including
+ * tiles only touched at a corner (supercover), optionally buffered to a
+ * corridor.
+ *
+ * The corridor contains all points within corridorMeters of the line along
+ * longitude and latitude, i.e. the line swept by a box. The longitude extent
+ * of the box is scaled per segment for its highest latitude, so the corridor
+ * is never narrower than requested. The corridor wraps around the
+ * antimeridian, but segments are straight lines in NDS coordinates and must
+ * not cross it.
+ *
+ * @param line
+ *                the vertices of the polyline
+ * @param level
+ *                the tile level, must be in range 0..15
+ * @param corridorMeters
+ *                the corridor half width in meters
+ * @return std::vector<TileRange>
+ */
+std::vector<TileRange> coverPolyline(const std::vector<NdsCoordinate> &line,
+                                     int level, double corridorMeters = 0);
+std::vector<TileRange> coverPolyline(const std::vector<Wgs84Coordinate> &line,
+                                     int level, double corridorMeters = 0);
+
+/**
+ * Computes the tiles of the given level intersecting a disc around a
+ * coordinate.
+ *
+ * Distances are measured in a local equirectangular projection at the
+ * latitude of the center, which is accurate for radii well below the earth
+ * radius. The column span of each row is derived directly from the tile grid,
+ * so no candidate tiles are tested. The disc wraps around the antimeridian
+ * and is clipped at the poles.
+ *
+ * @param center
+ *                the center of the disc
+ * @param radiusMeters
+ *                the radius in meters, must not be negative
+ * @param level
+ *                the tile level, must be in range 0..15
+ * @return std::vector<TileRange>
+ */
+std::vector<TileRange> coverRadius(const NdsCoordinate &center,
+                                   double radiusMeters, int level);
+std::vector<TileRange> coverRadius(const Wgs84Coordinate &center,
+                                   double radiusMeters, int level);
+
+/**
+ * Computes the tiles within k steps of a tile in the grid of its level,
+ * including diagonal steps, i.e. the (2k+1) x (2k+1) tiles around it.
+ * Columns wrap around at the antimeridian, rows end at the poles.
+ *
+ * @param tile
+ *                the center tile
+ * @param k
+ *                the ring count, must not be negative
+ * @return std::vector<TileRange>
+ */
+std::vector<TileRange> coverRing(const NdsTile &tile, int k);
+
+} // namespace nds
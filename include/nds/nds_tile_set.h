@@ -0,0 +1,266 @@
+#pragma once
+
+/**
+ * Compressed tile sets.
+ *
+ * A TileBitmap stores tile numbers of one level like a roaring bitmap: the
+ * numbers are split by their upper 16 bits into containers of 2^16 numbers.
+ * Sparse containers hold a sorted array of the lower 16 bits (2 bytes per
+ * tile), dense containers a bitmap of 8 KiB (1 bit per tile). As tile numbers
+ * follow the Morton order, a container is a square region of the map, so
+ * dense and sparse regions get the fitting representation.
+ *
+ * A TileSet holds one TileBitmap per level.
+ */
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+//
+#include "nds/nds_status.h"
+#include "nds/nds_tile.h"
+
+namespace nds {
+
+class TileBitmap {
+public:
+  /**
+   * Adds a tile number, must not be negative.
+   *
+   * @param nr
+   */
+  void add(int nr);
+  /**
+   * Adds the inclusive range of tile numbers.
+   *
+   * @param range
+   */
+  void add(const TileRange &range);
+  /**
+   * Adds sorted and disjoint ranges, e.g. of ranges(), in one pass over the
+   * containers.
+   *
+   * @param ranges
+   */
+  void add(const std::vector<TileRange> &ranges);
+  /**
+   * Removes a tile number.
+   *
+   * @param nr
+   * @return true, if the number was contained
+   */
+  bool remove(int nr);
+  /**
+   * Removes the inclusive range of tile numbers.
+   *
+   * @param range
+   */
+  void remove(const TileRange &range);
+  /**
+   * Removes sorted and disjoint ranges in one pass over the containers.
+   *
+   * @param ranges
+   */
+  void remove(const std::vector<TileRange> &ranges);
+  bool contains(int nr) const;
+
+  /**
+   * The number of tile numbers within the set.
+   */
+  uint64_t cardinality() const;
+  bool empty() const { return containers_.empty(); }
+  void clear() { containers_.clear(); }
+  /**
+   * The approximate heap memory used by the set.
+   */
+  size_t memoryUsage() const;
+
+  TileBitmap &operator|=(const TileBitmap &other);
+  TileBitmap &operator&=(const TileBitmap &other);
+  TileBitmap &operator-=(const TileBitmap &other);
+  bool operator==(const TileBitmap &other) const;
+
+  /**
+   * Calls fn(int nr) for each tile number in ascending, i.e. Morton order.
+   *
+   * @param fn
+   */
+  template <typename Fn> void forEach(Fn fn) const {
+    for (const Container &c : containers_) {
+      const uint32_t high = (uint32_t)c.key << 16;
+      if (c.words.empty()) {
+        for (uint16_t low : c.values) {
+          fn((int)(high | low));
+        }
+        continue;
+      }
+      for (uint32_t w = 0; w < kWords; w++) {
+        for (uint64_t bits = c.words[w]; bits != 0; bits &= bits - 1) {
+          fn((int)(high | w << 6 | countTrailingZeros(bits)));
+        }
+      }
+    }
+  }
+  /**
+   * Returns the tile numbers as sorted, disjoint and non-adjacent ranges.
+   *
+   * @return std::vector<TileRange>
+   */
+  std::vector<TileRange> ranges() const;
+
+private:
+  friend class TileSet;
+
+  /*
+   * Containers with more values are stored as bitmap.
+   */
+  static constexpr uint32_t kMaxArraySize = 4096;
+  static constexpr uint32_t kWords = 1024;
+
+  /*
+   * The tile numbers sharing the upper 16 bits key, either as sorted lower
+   * 16 bits or as bitmap of kWords words.
+   */
+  struct Container {
+    uint16_t key = 0;
+    uint32_t cardinality = 0;
+    std::vector<uint16_t> values;
+    std::vector<uint64_t> words;
+
+    bool contains(uint16_t low) const;
+  };
+
+  static int countTrailingZeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    return (int)std::bitset<64>((bits & (0 - bits)) - 1).count();
+#endif
+  }
+
+  Container *find(uint16_t key);
+  const Container *find(uint16_t key) const;
+  Container &findOrInsert(uint16_t key);
+
+  static void toBitmap(Container *c);
+  static void normalize(Container *c);
+  static Container unite(const Container &a, const Container &b);
+  static Container intersect(const Container &a, const Container &b);
+  static Container subtract(const Container &a, const Container &b);
+
+  /*
+   * Sorted by key, no empty containers.
+   */
+  std::vector<Container> containers_;
+};
+
+class TileSet {
+public:
+  /**
+   * Adds a tile.
+   *
+   * @param tile
+   */
+  void insert(const NdsTile &tile) {
+    levels_[tile.level()].add(tile.tileNumber());
+  }
+  /**
+   * Adds the tiles of a range of tile numbers of the given level.
+   *
+   * @param level
+   * @param range
+   */
+  void insert(int level, const TileRange &range);
+  bool erase(const NdsTile &tile) {
+    return levels_[tile.level()].remove(tile.tileNumber());
+  }
+  /**
+   * Removes the tiles of a range of tile numbers of the given level.
+   *
+   * @param level
+   * @param range
+   */
+  void erase(int level, const TileRange &range);
+  bool contains(const NdsTile &tile) const {
+    return levels_[tile.level()].contains(tile.tileNumber());
+  }
+
+  /**
+   * The number of tiles of all levels.
+   */
+  uint64_t size() const;
+  bool empty() const;
+  size_t memoryUsage() const;
+  /**
+   * The tile numbers of one level.
+   *
+   * @param level
+   *                  Must be in range 0..15
+   * @return const TileBitmap&
+   */
+  const TileBitmap &level(int level) const { return levels_[level]; }
+
+  /**
+   * Converts the set to the minimal set of tiles covering the same area:
+   * tiles within a tile of a lower level are dropped and four tiles with the
+   * same parent are replaced by the parent, recursively up to level 1. Runs
+   * on tile number ranges, removing and adding the ranges of each level in
+   * one pass, so the work is linear in the size of the set.
+   */
+  void normalize();
+  /**
+   * Replaces the tiles of the lower levels by their descendants of the given
+   * level and the tiles of the higher levels by their ancestors, i.e. the
+   * tiles of the level covering the area of the set. This is the inverse of
+   * normalize() for sets of that level.
+   *
+   * @param level
+   *                  Must be in range 0..15
+   */
+  void expand(int level);
+
+  TileSet &operator|=(const TileSet &other);
+  TileSet &operator&=(const TileSet &other);
+  TileSet &operator-=(const TileSet &other);
+  bool operator==(const TileSet &other) const;
+
+  /**
+   * Calls fn(NdsTile) for each tile, level by level and in Morton order
+   * within a level.
+   *
+   * @param fn
+   */
+  template <typename Fn> void forEach(Fn fn) const {
+    for (int level = 0; level <= kMaxLevel; level++) {
+      levels_[level].forEach([&](int nr) { fn(NdsTile(level, nr)); });
+    }
+  }
+
+  /**
+   * Appends the binary representation of the set: the magic "NDTS", a 16 bit
+   * mask of the non-empty levels and for each of them the number of
+   * containers, followed by key, cardinality - 1 and the values or bitmap
+   * words of each container. All numbers are little endian.
+   *
+   * @param out
+   */
+  void serialize(std::vector<uint8_t> *out) const;
+  /**
+   * Reads a set written by serialize().
+   *
+   * @param data
+   * @param size
+   * @return Result<TileSet> the set, or Status::kInvalidData if the data is
+   *         truncated or malformed
+   */
+  static Result<TileSet> deserialize(const uint8_t *data, size_t size);
+
+private:
+  TileBitmap levels_[kMaxLevel + 1];
+};
+
+inline TileSet operator|(TileSet a, const TileSet &b) { return a |= b; }
+inline TileSet operator&(TileSet a, const TileSet &b) { return a &= b; }
+inline TileSet operator-(TileSet a, const TileSet &b) { return a -= b; }
+
+} // namespace nds
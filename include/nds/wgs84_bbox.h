@@ -1,5 +1,5 @@
 #pragma once
-#include "configor/json.hpp"
+#include <string>
 //
 #include "nds/wgs84_coordinate.h"
 
@@ -20,18 +20,7 @@ public:
    *
    * @return
    */
-  std::string toGeoJSON() {
-    configor::json geojson;
-    geojson["type"] = "Feature";
-    geojson["properties"] = {};
-    geojson["geometry"]["type"] = "Polygon";
-    geojson["geometry"]["coordinates"] = {{west_, south_},
-                                          {east_, south_},
-                                          {east_, north_},
-                                          {west_, north_},
-                                          {west_, south_}};
-    return geojson.dump();
-  }
+  std::string toGeoJSON() const;
 
 private:
   double north_;
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <limits>
 #include <string>
+//
+#include "nds/nds_status.h"
 
 namespace nds {
 class Wgs84Coordinate {
@@ -18,6 +20,18 @@ public:
    */
   Wgs84Coordinate(double longitude, double latitude);
 
+  /**
+   * Creates a new WGS 84 coordinate without aborting on invalid input.
+   *
+   * @param longitude
+   *                      the longitude within [-180, 180]
+   * @param latitude
+   *                      the latitude within [-90, 90]
+   * @return Result<Wgs84Coordinate> the coordinate, or
+   *         Status::kInvalidLongitude / Status::kInvalidLatitude
+   */
+  static Result<Wgs84Coordinate> create(double longitude, double latitude);
+
   double longitude() const { return longitude_; }
   double latitude() const { return latitude_; }
   /**
@@ -25,9 +39,11 @@ public:
    *
    * @return
    */
-  std::string toGeoJSON();
+  std::string toGeoJSON() const;
 
 private:
+  Wgs84Coordinate() = default;
+
   double longitude_;
   double latitude_;
 };
@@ -0,0 +1,62 @@
+#pragma once
+/**
+ * Runtime detection of the x86 instruction set extensions used by the
+ * optimized code paths. The kernels themselves are compiled with function
+ * level target attributes, so the library keeps running on CPUs without
+ * the extensions and no global compiler flags are required.
+ */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define NDS_X86_DISPATCH 1
+#endif
+
+namespace nds {
+namespace cpu {
+
+/**
+ * Checks if PDEP/PEXT are available and fast. AMD Zen1/Zen2 implement BMI2 in
+ * microcode with a latency of up to ~250 cycles, so they are treated as
+ * unsupported.
+ *
+ * @return bool
+ */
+inline bool hasFastBmi2() {
+#ifdef NDS_X86_DISPATCH
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("znver1") &&
+         !__builtin_cpu_is("znver2");
+#else
+  return false;
+#endif
+}
+
+/**
+ * Checks if AVX2 is available (including OS support for the YMM state).
+ *
+ * @return bool
+ */
+inline bool hasAvx2() {
+#ifdef NDS_X86_DISPATCH
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+/**
+ * Checks if AVX-512 Foundation is available (including OS support for the ZMM
+ * state).
+ *
+ * @return bool
+ */
+inline bool hasAvx512() {
+#ifdef NDS_X86_DISPATCH
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f");
+#else
+  return false;
+#endif
+}
+
+} // namespace cpu
+} // namespace nds
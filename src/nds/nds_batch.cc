@@ -0,0 +1,765 @@
+#include "nds/nds_batch.h"
+//
+#include "cpu_features.h"
+#include "nds/nds_coordinate.h"
+#include "nds/nds_morton.h"
+#include "nds/nds_tile.h"
+#include <algorithm>
+#include <cmath>
+#include <glog/logging.h>
+#include <limits>
+#ifdef NDS_X86_DISPATCH
+/*
+ * The AVX-512 intrinsics of GCC 12 pass the self-initialized vector of
+ * _mm512_undefined_si512() as merge source, which -Wmaybe-uninitialized
+ * reports at every inlined call of the kernels below (GCC bug 105593).
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#else
+#include <immintrin.h>
+#endif
+#endif
+
+namespace nds {
+namespace {
+/*
+ * Number of coordinates processed per block, so the Morton codes are computed
+ * while the converted coordinates are still in the L1 cache.
+ */
+constexpr size_t kBlockSize = 1024;
+
+constexpr double kLongitudeScale = (double)kLongitudeRange;
+constexpr double kLatitudeScale = (double)kLatitudeRange;
+
+/*
+ * Converts a floored value like the x86 conversion instructions do: NaN and
+ * values outside the int32 range become INT32_MIN. Casting them would be
+ * undefined, and they only occur for invalid input.
+ */
+inline int32_t toInt32(double v) {
+  return v >= -2147483648.0 && v < 2147483648.0
+             ? (int32_t)v
+             : std::numeric_limits<int32_t>::min();
+}
+
+/*
+ * Same operation order as NdsCoordinate(double lon, double lat), which keeps
+ * the results bit-identical.
+ */
+inline int32_t toNdsLongitude(double lon) {
+  return toInt32(std::floor(lon / 360.0 * kLongitudeScale));
+}
+
+inline int32_t toNdsLatitude(double lat) {
+  return toInt32(std::floor(lat / 180.0 * kLatitudeScale));
+}
+
+/*
+ * NaN fails all comparisons and is therefore out of range.
+ */
+inline bool inRange(double lon, double lat) {
+  return lon >= -180 && lon <= 180 && lat >= -90 && lat <= 90;
+}
+
+/*
+ * The kernels return false if any coordinate is out of range.
+ */
+using ConvertFn = bool (*)(const double *, const double *, size_t, int32_t *,
+                           int32_t *);
+
+bool convertScalar(const double *lon, const double *lat, size_t count,
+                   int32_t *ndsLon, int32_t *ndsLat) {
+  bool valid = true;
+  for (size_t i = 0; i < count; i++) {
+    valid &= inRange(lon[i], lat[i]);
+    ndsLon[i] = toNdsLongitude(lon[i]);
+    ndsLat[i] = toNdsLatitude(lat[i]);
+  }
+  return valid;
+}
+
+#ifdef NDS_X86_DISPATCH
+/*
+ * SSE2 has no floor instruction: truncate and correct the values which were
+ * rounded up.
+ */
+inline __m128i floorToInt32(__m128d x) {
+  __m128i t = _mm_cvttpd_epi32(x);
+  __m128d roundedUp = _mm_cmpgt_pd(_mm_cvtepi32_pd(t), x);
+  __m128i correction = _mm_shuffle_epi32(_mm_castpd_si128(roundedUp),
+                                         _MM_SHUFFLE(3, 3, 2, 0));
+  return _mm_add_epi32(t, correction);
+}
+
+bool convertSse2(const double *lon, const double *lat, size_t count,
+                 int32_t *ndsLon, int32_t *ndsLat) {
+  const __m128d lonMin = _mm_set1_pd(-180.0), lonMax = _mm_set1_pd(180.0);
+  const __m128d latMin = _mm_set1_pd(-90.0), latMax = _mm_set1_pd(90.0);
+  const __m128d lonDiv = _mm_set1_pd(360.0), latDiv = _mm_set1_pd(180.0);
+  const __m128d lonScale = _mm_set1_pd(kLongitudeScale);
+  const __m128d latScale = _mm_set1_pd(kLatitudeScale);
+  __m128d invalid = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d x = _mm_loadu_pd(lon + i);
+    __m128d y = _mm_loadu_pd(lat + i);
+    invalid = _mm_or_pd(invalid, _mm_or_pd(_mm_cmpnge_pd(x, lonMin),
+                                           _mm_cmpnle_pd(x, lonMax)));
+    invalid = _mm_or_pd(invalid, _mm_or_pd(_mm_cmpnge_pd(y, latMin),
+                                           _mm_cmpnle_pd(y, latMax)));
+    __m128i ix = floorToInt32(_mm_mul_pd(_mm_div_pd(x, lonDiv), lonScale));
+    __m128i iy = floorToInt32(_mm_mul_pd(_mm_div_pd(y, latDiv), latScale));
+    _mm_storel_epi64((__m128i *)(ndsLon + i), ix);
+    _mm_storel_epi64((__m128i *)(ndsLat + i), iy);
+  }
+  bool valid = _mm_movemask_pd(invalid) == 0;
+  return convertScalar(lon + i, lat + i, count - i, ndsLon + i, ndsLat + i) &&
+         valid;
+}
+
+__attribute__((target("avx2"))) bool convertAvx2(const double *lon,
+                                                 const double *lat,
+                                                 size_t count, int32_t *ndsLon,
+                                                 int32_t *ndsLat) {
+  const __m256d lonMin = _mm256_set1_pd(-180.0), lonMax = _mm256_set1_pd(180.0);
+  const __m256d latMin = _mm256_set1_pd(-90.0), latMax = _mm256_set1_pd(90.0);
+  const __m256d lonDiv = _mm256_set1_pd(360.0), latDiv = _mm256_set1_pd(180.0);
+  const __m256d lonScale = _mm256_set1_pd(kLongitudeScale);
+  const __m256d latScale = _mm256_set1_pd(kLatitudeScale);
+  __m256d invalid = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d x = _mm256_loadu_pd(lon + i);
+    __m256d y = _mm256_loadu_pd(lat + i);
+    invalid = _mm256_or_pd(
+        invalid, _mm256_or_pd(_mm256_cmp_pd(x, lonMin, _CMP_NGE_UQ),
+                              _mm256_cmp_pd(x, lonMax, _CMP_NLE_UQ)));
+    invalid = _mm256_or_pd(
+        invalid, _mm256_or_pd(_mm256_cmp_pd(y, latMin, _CMP_NGE_UQ),
+                              _mm256_cmp_pd(y, latMax, _CMP_NLE_UQ)));
+    x = _mm256_floor_pd(_mm256_mul_pd(_mm256_div_pd(x, lonDiv), lonScale));
+    y = _mm256_floor_pd(_mm256_mul_pd(_mm256_div_pd(y, latDiv), latScale));
+    _mm_storeu_si128((__m128i *)(ndsLon + i), _mm256_cvtpd_epi32(x));
+    _mm_storeu_si128((__m128i *)(ndsLat + i), _mm256_cvtpd_epi32(y));
+  }
+  bool valid = _mm256_movemask_pd(invalid) == 0;
+  return convertScalar(lon + i, lat + i, count - i, ndsLon + i, ndsLat + i) &&
+         valid;
+}
+
+__attribute__((target("avx512f"))) bool
+convertAvx512(const double *lon, const double *lat, size_t count,
+              int32_t *ndsLon, int32_t *ndsLat) {
+  const __m512d lonMin = _mm512_set1_pd(-180.0), lonMax = _mm512_set1_pd(180.0);
+  const __m512d latMin = _mm512_set1_pd(-90.0), latMax = _mm512_set1_pd(90.0);
+  const __m512d lonDiv = _mm512_set1_pd(360.0), latDiv = _mm512_set1_pd(180.0);
+  const __m512d lonScale = _mm512_set1_pd(kLongitudeScale);
+  const __m512d latScale = _mm512_set1_pd(kLatitudeScale);
+  __mmask8 invalid = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512d x = _mm512_loadu_pd(lon + i);
+    __m512d y = _mm512_loadu_pd(lat + i);
+    invalid |= _mm512_cmp_pd_mask(x, lonMin, _CMP_NGE_UQ) |
+               _mm512_cmp_pd_mask(x, lonMax, _CMP_NLE_UQ) |
+               _mm512_cmp_pd_mask(y, latMin, _CMP_NGE_UQ) |
+               _mm512_cmp_pd_mask(y, latMax, _CMP_NLE_UQ);
+    x = _mm512_roundscale_pd(
+        _mm512_mul_pd(_mm512_div_pd(x, lonDiv), lonScale),
+        _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    y = _mm512_roundscale_pd(
+        _mm512_mul_pd(_mm512_div_pd(y, latDiv), latScale),
+        _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    _mm256_storeu_si256((__m256i *)(ndsLon + i), _mm512_cvtpd_epi32(x));
+    _mm256_storeu_si256((__m256i *)(ndsLat + i), _mm512_cvtpd_epi32(y));
+  }
+  return convertScalar(lon + i, lat + i, count - i, ndsLon + i, ndsLat + i) &&
+         invalid == 0;
+}
+#endif
+
+ConvertFn convertKernel(SimdLevel level) {
+#ifdef NDS_X86_DISPATCH
+  switch (level) {
+  case SimdLevel::kAvx512:
+    return convertAvx512;
+  case SimdLevel::kAvx2:
+    return convertAvx2;
+  case SimdLevel::kSse2:
+    return convertSse2;
+  default:
+    break;
+  }
+#endif
+  return convertScalar;
+}
+
+/*
+ * Morton kernels. The vector variants apply the magic-number bit spreading of
+ * morton::spreadBits()/compactBits() to 64-bit lanes.
+ */
+using EncodeFn = void (*)(const int32_t *, const int32_t *, size_t, int64_t *);
+using DecodeFn = void (*)(const int64_t *, size_t, int32_t *, int32_t *);
+
+void encodeScalar(const int32_t *ndsLon, const int32_t *ndsLat, size_t count,
+                  int64_t *mortonCodes) {
+  for (size_t i = 0; i < count; i++) {
+    mortonCodes[i] = morton::encode(ndsLon[i], ndsLat[i]);
+  }
+}
+
+void decodeScalar(const int64_t *mortonCodes, size_t count, int32_t *ndsLon,
+                  int32_t *ndsLat) {
+  for (size_t i = 0; i < count; i++) {
+    morton::decode(mortonCodes[i], ndsLon + i, ndsLat + i);
+  }
+}
+
+#ifdef NDS_X86_DISPATCH
+constexpr int64_t kSpreadMasks[] = {
+    0x0000FFFF0000FFFFLL, 0x00FF00FF00FF00FFLL, 0x0F0F0F0F0F0F0F0FLL,
+    0x3333333333333333LL, 0x5555555555555555LL};
+constexpr int64_t kLatitudeBits = 0x7FFFFFFFLL;
+constexpr int64_t kLowWord = 0xFFFFFFFFLL;
+
+inline __m128i spreadBits(__m128i x) {
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 16)),
+                    _mm_set1_epi64x(kSpreadMasks[0]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 8)),
+                    _mm_set1_epi64x(kSpreadMasks[1]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 4)),
+                    _mm_set1_epi64x(kSpreadMasks[2]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 2)),
+                    _mm_set1_epi64x(kSpreadMasks[3]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 1)),
+                    _mm_set1_epi64x(kSpreadMasks[4]));
+  return x;
+}
+
+inline __m128i compactBits(__m128i x) {
+  x = _mm_and_si128(x, _mm_set1_epi64x(kSpreadMasks[4]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_srli_epi64(x, 1)),
+                    _mm_set1_epi64x(kSpreadMasks[3]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_srli_epi64(x, 2)),
+                    _mm_set1_epi64x(kSpreadMasks[2]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_srli_epi64(x, 4)),
+                    _mm_set1_epi64x(kSpreadMasks[1]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_srli_epi64(x, 8)),
+                    _mm_set1_epi64x(kSpreadMasks[0]));
+  x = _mm_and_si128(_mm_or_si128(x, _mm_srli_epi64(x, 16)),
+                    _mm_set1_epi64x(kLowWord));
+  return x;
+}
+
+/*
+ * Moves the low 32 bits of both 64-bit lanes into the low 64 bits.
+ */
+inline __m128i packLow32(__m128i x) {
+  return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 2, 0));
+}
+
+void encodeSse2(const int32_t *ndsLon, const int32_t *ndsLat, size_t count,
+                int64_t *mortonCodes) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128i x = _mm_loadl_epi64((const __m128i *)(ndsLon + i));
+    __m128i y = _mm_loadl_epi64((const __m128i *)(ndsLat + i));
+    x = _mm_unpacklo_epi32(x, zero);
+    y = _mm_unpacklo_epi32(y, zero);
+    // The latitude sign is copied to bit 61, see morton::encodePortable().
+    __m128i sign = _mm_slli_epi64(_mm_srli_epi64(y, 31), 61);
+    y = _mm_and_si128(y, _mm_set1_epi64x(kLatitudeBits));
+    __m128i code = _mm_or_si128(
+        _mm_or_si128(spreadBits(x), _mm_slli_epi64(spreadBits(y), 1)), sign);
+    _mm_storeu_si128((__m128i *)(mortonCodes + i), code);
+  }
+  encodeScalar(ndsLon + i, ndsLat + i, count - i, mortonCodes + i);
+}
+
+void decodeSse2(const int64_t *mortonCodes, size_t count, int32_t *ndsLon,
+                int32_t *ndsLat) {
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128i code = _mm_loadu_si128((const __m128i *)(mortonCodes + i));
+    __m128i x = packLow32(compactBits(code));
+    __m128i y = packLow32(compactBits(_mm_srli_epi64(code, 1)));
+    // The latitude is a 31-bit signed integer, extend bit 30 into bit 31.
+    y = _mm_srai_epi32(_mm_slli_epi32(y, 1), 1);
+    _mm_storel_epi64((__m128i *)(ndsLon + i), x);
+    _mm_storel_epi64((__m128i *)(ndsLat + i), y);
+  }
+  decodeScalar(mortonCodes + i, count - i, ndsLon + i, ndsLat + i);
+}
+
+__attribute__((target("avx2"))) inline __m256i spreadBits(__m256i x) {
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 16)),
+                       _mm256_set1_epi64x(kSpreadMasks[0]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 8)),
+                       _mm256_set1_epi64x(kSpreadMasks[1]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 4)),
+                       _mm256_set1_epi64x(kSpreadMasks[2]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 2)),
+                       _mm256_set1_epi64x(kSpreadMasks[3]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 1)),
+                       _mm256_set1_epi64x(kSpreadMasks[4]));
+  return x;
+}
+
+__attribute__((target("avx2"))) inline __m256i compactBits(__m256i x) {
+  x = _mm256_and_si256(x, _mm256_set1_epi64x(kSpreadMasks[4]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 1)),
+                       _mm256_set1_epi64x(kSpreadMasks[3]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 2)),
+                       _mm256_set1_epi64x(kSpreadMasks[2]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 4)),
+                       _mm256_set1_epi64x(kSpreadMasks[1]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 8)),
+                       _mm256_set1_epi64x(kSpreadMasks[0]));
+  x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 16)),
+                       _mm256_set1_epi64x(kLowWord));
+  return x;
+}
+
+__attribute__((target("avx2"))) inline __m128i packLow32(__m256i x) {
+  const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(x, even));
+}
+
+__attribute__((target("avx2"))) void encodeAvx2(const int32_t *ndsLon,
+                                                const int32_t *ndsLat,
+                                                size_t count,
+                                                int64_t *mortonCodes) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i x =
+        _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(ndsLon + i)));
+    __m256i y =
+        _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(ndsLat + i)));
+    __m256i sign = _mm256_slli_epi64(_mm256_srli_epi64(y, 31), 61);
+    y = _mm256_and_si256(y, _mm256_set1_epi64x(kLatitudeBits));
+    __m256i code = _mm256_or_si256(
+        _mm256_or_si256(spreadBits(x), _mm256_slli_epi64(spreadBits(y), 1)),
+        sign);
+    _mm256_storeu_si256((__m256i *)(mortonCodes + i), code);
+  }
+  encodeScalar(ndsLon + i, ndsLat + i, count - i, mortonCodes + i);
+}
+
+__attribute__((target("avx2"))) void decodeAvx2(const int64_t *mortonCodes,
+                                                size_t count, int32_t *ndsLon,
+                                                int32_t *ndsLat) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i code = _mm256_loadu_si256((const __m256i *)(mortonCodes + i));
+    __m128i x = packLow32(compactBits(code));
+    __m128i y = packLow32(compactBits(_mm256_srli_epi64(code, 1)));
+    y = _mm_srai_epi32(_mm_slli_epi32(y, 1), 1);
+    _mm_storeu_si128((__m128i *)(ndsLon + i), x);
+    _mm_storeu_si128((__m128i *)(ndsLat + i), y);
+  }
+  decodeScalar(mortonCodes + i, count - i, ndsLon + i, ndsLat + i);
+}
+
+/*
+ * With AVX-512 each (x | shifted) & mask step is a single ternary logic
+ * instruction; 0xA8 is the truth table of (a | b) & c.
+ */
+__attribute__((target("avx512f"))) inline __m512i
+orAnd(__m512i a, __m512i b, int64_t mask) {
+  return _mm512_ternarylogic_epi64(a, b, _mm512_set1_epi64(mask), 0xA8);
+}
+
+__attribute__((target("avx512f"))) inline __m512i spreadBits(__m512i x) {
+  x = orAnd(x, _mm512_slli_epi64(x, 16), kSpreadMasks[0]);
+  x = orAnd(x, _mm512_slli_epi64(x, 8), kSpreadMasks[1]);
+  x = orAnd(x, _mm512_slli_epi64(x, 4), kSpreadMasks[2]);
+  x = orAnd(x, _mm512_slli_epi64(x, 2), kSpreadMasks[3]);
+  x = orAnd(x, _mm512_slli_epi64(x, 1), kSpreadMasks[4]);
+  return x;
+}
+
+__attribute__((target("avx512f"))) inline __m512i compactBits(__m512i x) {
+  x = _mm512_and_si512(x, _mm512_set1_epi64(kSpreadMasks[4]));
+  x = orAnd(x, _mm512_srli_epi64(x, 1), kSpreadMasks[3]);
+  x = orAnd(x, _mm512_srli_epi64(x, 2), kSpreadMasks[2]);
+  x = orAnd(x, _mm512_srli_epi64(x, 4), kSpreadMasks[1]);
+  x = orAnd(x, _mm512_srli_epi64(x, 8), kSpreadMasks[0]);
+  x = orAnd(x, _mm512_srli_epi64(x, 16), kLowWord);
+  return x;
+}
+
+__attribute__((target("avx512f"))) void
+encodeAvx512(const int32_t *ndsLon, const int32_t *ndsLat, size_t count,
+             int64_t *mortonCodes) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512i x = _mm512_cvtepu32_epi64(
+        _mm256_loadu_si256((const __m256i *)(ndsLon + i)));
+    __m512i y = _mm512_cvtepu32_epi64(
+        _mm256_loadu_si256((const __m256i *)(ndsLat + i)));
+    __m512i sign = _mm512_slli_epi64(_mm512_srli_epi64(y, 31), 61);
+    y = _mm512_and_si512(y, _mm512_set1_epi64(kLatitudeBits));
+    __m512i code = _mm512_ternarylogic_epi64(
+        spreadBits(x), _mm512_slli_epi64(spreadBits(y), 1), sign, 0xFE);
+    _mm512_storeu_si512((void *)(mortonCodes + i), code);
+  }
+  encodeScalar(ndsLon + i, ndsLat + i, count - i, mortonCodes + i);
+}
+
+__attribute__((target("avx512f"))) void
+decodeAvx512(const int64_t *mortonCodes, size_t count, int32_t *ndsLon,
+             int32_t *ndsLat) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512i code = _mm512_loadu_si512((const void *)(mortonCodes + i));
+    __m256i x = _mm512_cvtepi64_epi32(compactBits(code));
+    __m256i y = _mm512_cvtepi64_epi32(compactBits(_mm512_srli_epi64(code, 1)));
+    y = _mm256_srai_epi32(_mm256_slli_epi32(y, 1), 1);
+    _mm256_storeu_si256((__m256i *)(ndsLon + i), x);
+    _mm256_storeu_si256((__m256i *)(ndsLat + i), y);
+  }
+  decodeScalar(mortonCodes + i, count - i, ndsLon + i, ndsLat + i);
+}
+#endif
+
+/*
+ * Packed ID kernels. The vector variants find the level bit by converting
+ * the ID bits 15..31 to float: the exponent is the position of the highest
+ * set bit, and masking the mantissa yields the level bit itself. Bit 15 is
+ * set beforehand, so IDs without level bit end up on level -1.
+ */
+using DecodeIdsFn = size_t (*)(const int32_t *, size_t, int32_t *, int32_t *);
+
+size_t decodeIdsScalar(const int32_t *packedIds, size_t count,
+                       int32_t *tileLevels, int32_t *tileNumbers) {
+  size_t invalid = 0;
+  for (size_t i = 0; i < count; i++) {
+    int tileLevel = NdsTile::extractLevel(packedIds[i]);
+    tileLevels[i] = tileLevel;
+    tileNumbers[i] = packedIds[i] ^ levelBit(tileLevel);
+    invalid += tileLevel < 0;
+  }
+  return invalid;
+}
+
+#ifdef NDS_X86_DISPATCH
+constexpr int32_t kExponentMask = (int32_t)0xFF800000;
+
+size_t decodeIdsSse2(const int32_t *packedIds, size_t count,
+                     int32_t *tileLevels, int32_t *tileNumbers) {
+  const __m128i bit15 = _mm_set1_epi32(0x8000);
+  const __m128i bias = _mm_set1_epi32(128);
+  const __m128i exponentMask = _mm_set1_epi32(kExponentMask);
+  const __m128i noLevel = _mm_set1_epi32(-1);
+  __m128i invalid = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i id = _mm_loadu_si128((const __m128i *)(packedIds + i));
+    __m128i top = _mm_srli_epi32(_mm_or_si128(id, bit15), 15);
+    __m128i f = _mm_castps_si128(_mm_cvtepi32_ps(top));
+    __m128i tileLevel = _mm_sub_epi32(_mm_srli_epi32(f, 23), bias);
+    __m128i bit = _mm_slli_epi32(
+        _mm_cvttps_epi32(_mm_castsi128_ps(_mm_and_si128(f, exponentMask))),
+        15);
+    _mm_storeu_si128((__m128i *)(tileLevels + i), tileLevel);
+    _mm_storeu_si128((__m128i *)(tileNumbers + i), _mm_xor_si128(id, bit));
+    invalid = _mm_sub_epi32(invalid, _mm_cmpeq_epi32(tileLevel, noLevel));
+  }
+  int32_t lanes[4];
+  _mm_storeu_si128((__m128i *)lanes, invalid);
+  return (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         decodeIdsScalar(packedIds + i, count - i, tileLevels + i,
+                         tileNumbers + i);
+}
+
+__attribute__((target("avx2"))) size_t
+decodeIdsAvx2(const int32_t *packedIds, size_t count, int32_t *tileLevels,
+              int32_t *tileNumbers) {
+  const __m256i bit15 = _mm256_set1_epi32(0x8000);
+  const __m256i bias = _mm256_set1_epi32(128);
+  const __m256i exponentMask = _mm256_set1_epi32(kExponentMask);
+  const __m256i noLevel = _mm256_set1_epi32(-1);
+  __m256i invalid = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i id = _mm256_loadu_si256((const __m256i *)(packedIds + i));
+    __m256i top = _mm256_srli_epi32(_mm256_or_si256(id, bit15), 15);
+    __m256i f = _mm256_castps_si256(_mm256_cvtepi32_ps(top));
+    __m256i tileLevel = _mm256_sub_epi32(_mm256_srli_epi32(f, 23), bias);
+    __m256i bit = _mm256_slli_epi32(
+        _mm256_cvttps_epi32(
+            _mm256_castsi256_ps(_mm256_and_si256(f, exponentMask))),
+        15);
+    _mm256_storeu_si256((__m256i *)(tileLevels + i), tileLevel);
+    _mm256_storeu_si256((__m256i *)(tileNumbers + i),
+                        _mm256_xor_si256(id, bit));
+    invalid =
+        _mm256_sub_epi32(invalid, _mm256_cmpeq_epi32(tileLevel, noLevel));
+  }
+  int32_t lanes[8];
+  _mm256_storeu_si256((__m256i *)lanes, invalid);
+  size_t sum = 0;
+  for (int32_t lane : lanes) {
+    sum += lane;
+  }
+  return sum + decodeIdsScalar(packedIds + i, count - i, tileLevels + i,
+                               tileNumbers + i);
+}
+
+__attribute__((target("avx512f"))) size_t
+decodeIdsAvx512(const int32_t *packedIds, size_t count, int32_t *tileLevels,
+                int32_t *tileNumbers) {
+  const __m512i bit15 = _mm512_set1_epi32(0x8000);
+  const __m512i bias = _mm512_set1_epi32(128);
+  const __m512i exponentMask = _mm512_set1_epi32(kExponentMask);
+  const __m512i noLevel = _mm512_set1_epi32(-1);
+  size_t invalid = 0;
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512i id = _mm512_loadu_si512((const void *)(packedIds + i));
+    __m512i top = _mm512_srli_epi32(_mm512_or_si512(id, bit15), 15);
+    __m512i f = _mm512_castps_si512(_mm512_cvtepi32_ps(top));
+    __m512i tileLevel = _mm512_sub_epi32(_mm512_srli_epi32(f, 23), bias);
+    __m512i bit = _mm512_slli_epi32(
+        _mm512_cvttps_epi32(
+            _mm512_castsi512_ps(_mm512_and_si512(f, exponentMask))),
+        15);
+    _mm512_storeu_si512((void *)(tileLevels + i), tileLevel);
+    _mm512_storeu_si512((void *)(tileNumbers + i), _mm512_xor_si512(id, bit));
+    invalid += __builtin_popcount(_mm512_cmpeq_epi32_mask(tileLevel, noLevel));
+  }
+  return invalid + decodeIdsScalar(packedIds + i, count - i, tileLevels + i,
+                                   tileNumbers + i);
+}
+#endif
+
+DecodeIdsFn decodeIdsKernel(SimdLevel level) {
+#ifdef NDS_X86_DISPATCH
+  switch (level) {
+  case SimdLevel::kAvx512:
+    return decodeIdsAvx512;
+  case SimdLevel::kAvx2:
+    return decodeIdsAvx2;
+  case SimdLevel::kSse2:
+    return decodeIdsSse2;
+  default:
+    break;
+  }
+#endif
+  return decodeIdsScalar;
+}
+
+EncodeFn encodeKernel(SimdLevel level) {
+#ifdef NDS_X86_DISPATCH
+  switch (level) {
+  case SimdLevel::kAvx512:
+    return encodeAvx512;
+  case SimdLevel::kAvx2:
+    return encodeAvx2;
+  case SimdLevel::kSse2:
+    return encodeSse2;
+  default:
+    break;
+  }
+#endif
+  return encodeScalar;
+}
+
+DecodeFn decodeKernel(SimdLevel level) {
+#ifdef NDS_X86_DISPATCH
+  switch (level) {
+  case SimdLevel::kAvx512:
+    return decodeAvx512;
+  case SimdLevel::kAvx2:
+    return decodeAvx2;
+  case SimdLevel::kSse2:
+    return decodeSse2;
+  default:
+    break;
+  }
+#endif
+  return decodeScalar;
+}
+
+SimdLevel supportedLevel(SimdLevel level) {
+  return std::min(level, maxSimdLevel());
+}
+
+/*
+ * The tile number is identical to the (2*level+1) most-significant bits of the
+ * Morton code, the packed ID adds the level bit on top. For level 15 the
+ * level bit is the sign bit, hence the unsigned arithmetic.
+ */
+void mortonToPackedIds(const int64_t *mortonCodes, size_t count,
+                       int tileLevel, int32_t *packedIds) {
+  const int shift = mortonShift(tileLevel);
+  const uint32_t bit = (uint32_t)levelBit(tileLevel);
+  for (size_t i = 0; i < count; i++) {
+    packedIds[i] = (int32_t)((uint32_t)(mortonCodes[i] >> shift) + bit);
+  }
+}
+
+void checkTileLevels(const int *tileLevels, size_t levelCount) {
+  for (size_t j = 0; j < levelCount; j++) {
+    if (tileLevels[j] < 0 || tileLevels[j] > kMaxLevel) {
+      LOG(FATAL) << "The Tile level " << tileLevels[j]
+                 << " exceeds the range [0, 15].";
+    }
+  }
+}
+
+/*
+ * Reports the first invalid NDS latitude the same way as
+ * NdsCoordinate(int, int) does.
+ */
+void reportInvalid(const int32_t *ndsLat, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (ndsLat[i] < kMinLatitude || kMaxLatitude < ndsLat[i]) {
+      LOG(FATAL) << "Latitude value " << ndsLat[i] << " at index " << i
+                 << " exceeds allowed range [-2^30; 2^30] [" << kMinLatitude
+                 << "," << kMaxLatitude << "].";
+    }
+  }
+}
+
+/*
+ * Reports the first invalid coordinate the same way as the NdsCoordinate
+ * constructor does.
+ */
+void reportInvalid(const double *lon, const double *lat, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (!(lon[i] >= -180 && lon[i] <= 180)) {
+      LOG(FATAL) << "The longitude value " << lon[i] << " at index " << i
+                 << " exceeds the valid range of [-180; 180]" << std::endl;
+    }
+    if (!(lat[i] >= -90 && lat[i] <= 90)) {
+      LOG(FATAL) << "The latitude value " << lat[i] << " at index " << i
+                 << " exceeds the valid range of [-90; 90]" << std::endl;
+    }
+  }
+}
+} // namespace
+
+SimdLevel maxSimdLevel() {
+  static const SimdLevel detected = [] {
+#ifdef NDS_X86_DISPATCH
+    if (cpu::hasAvx512()) {
+      return SimdLevel::kAvx512;
+    }
+    if (cpu::hasAvx2()) {
+      return SimdLevel::kAvx2;
+    }
+    // SSE2 is part of the x86-64 baseline.
+    return SimdLevel::kSse2;
+#else
+    return SimdLevel::kScalar;
+#endif
+  }();
+  return detected;
+}
+
+void convertWgs84ToNds(const double *lon, const double *lat, size_t count,
+                       int32_t *ndsLon, int32_t *ndsLat, int64_t *mortonCodes,
+                       SimdLevel level) {
+  ConvertFn convert = convertKernel(supportedLevel(level));
+  EncodeFn encode = encodeKernel(supportedLevel(level));
+  bool valid = true;
+  for (size_t begin = 0; begin < count; begin += kBlockSize) {
+    size_t n = std::min(kBlockSize, count - begin);
+    valid &= convert(lon + begin, lat + begin, n, ndsLon + begin,
+                     ndsLat + begin);
+    if (mortonCodes != nullptr) {
+      encode(ndsLon + begin, ndsLat + begin, n, mortonCodes + begin);
+    }
+  }
+  if (!valid) {
+    reportInvalid(lon, lat, count);
+  }
+}
+
+void encodeMortonCodes(const int32_t *ndsLon, const int32_t *ndsLat,
+                       size_t count, int64_t *mortonCodes, SimdLevel level) {
+  encodeKernel(supportedLevel(level))(ndsLon, ndsLat, count, mortonCodes);
+}
+
+void decodeMortonCodes(const int64_t *mortonCodes, size_t count,
+                       int32_t *ndsLon, int32_t *ndsLat, SimdLevel level) {
+  /*
+   * The decoded latitude is always a sign extended 31-bit value, so the range
+   * check of NdsCoordinate(int64_t) can not fail and is skipped.
+   */
+  decodeKernel(supportedLevel(level))(mortonCodes, count, ndsLon, ndsLat);
+}
+
+void computePackedTileIds(const double *lon, const double *lat, size_t count,
+                          int tileLevel, int32_t *packedIds, SimdLevel level) {
+  computePackedTileIds(lon, lat, count, &tileLevel, 1, packedIds, level);
+}
+
+void computePackedTileIds(const double *lon, const double *lat, size_t count,
+                          const int *tileLevels, size_t levelCount,
+                          int32_t *packedIds, SimdLevel level) {
+  checkTileLevels(tileLevels, levelCount);
+  ConvertFn convert = convertKernel(supportedLevel(level));
+  EncodeFn encode = encodeKernel(supportedLevel(level));
+  int32_t ndsLon[kBlockSize];
+  int32_t ndsLat[kBlockSize];
+  int64_t mortonCodes[kBlockSize];
+  bool valid = true;
+  for (size_t begin = 0; begin < count; begin += kBlockSize) {
+    size_t n = std::min(kBlockSize, count - begin);
+    valid &= convert(lon + begin, lat + begin, n, ndsLon, ndsLat);
+    encode(ndsLon, ndsLat, n, mortonCodes);
+    for (size_t j = 0; j < levelCount; j++) {
+      mortonToPackedIds(mortonCodes, n, tileLevels[j],
+                        packedIds + j * count + begin);
+    }
+  }
+  if (!valid) {
+    reportInvalid(lon, lat, count);
+  }
+}
+
+void computePackedTileIds(const int32_t *ndsLon, const int32_t *ndsLat,
+                          size_t count, int tileLevel, int32_t *packedIds,
+                          SimdLevel level) {
+  computePackedTileIds(ndsLon, ndsLat, count, &tileLevel, 1, packedIds, level);
+}
+
+void computePackedTileIds(const int32_t *ndsLon, const int32_t *ndsLat,
+                          size_t count, const int *tileLevels,
+                          size_t levelCount, int32_t *packedIds,
+                          SimdLevel level) {
+  checkTileLevels(tileLevels, levelCount);
+  EncodeFn encode = encodeKernel(supportedLevel(level));
+  int64_t mortonCodes[kBlockSize];
+  bool valid = true;
+  for (size_t begin = 0; begin < count; begin += kBlockSize) {
+    size_t n = std::min(kBlockSize, count - begin);
+    for (size_t i = begin; i < begin + n; i++) {
+      valid &= kMinLatitude <= ndsLat[i] && ndsLat[i] <= kMaxLatitude;
+    }
+    encode(ndsLon + begin, ndsLat + begin, n, mortonCodes);
+    for (size_t j = 0; j < levelCount; j++) {
+      mortonToPackedIds(mortonCodes, n, tileLevels[j],
+                        packedIds + j * count + begin);
+    }
+  }
+  if (!valid) {
+    reportInvalid(ndsLat, count);
+  }
+}
+
+size_t decodePackedTileIds(const int32_t *packedIds, size_t count,
+                           int32_t *tileLevels, int32_t *tileNumbers,
+                           SimdLevel level) {
+  return decodeIdsKernel(supportedLevel(level))(packedIds, count, tileLevels,
+                                                tileNumbers);
+}
+
+} // namespace nds
@@ -0,0 +1,333 @@
+#include "nds/nds_binary_file.h"
+//
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+//
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace nds {
+namespace {
+constexpr uint8_t kMagic[4] = {'N', 'D', 'S', 'B'};
+constexpr size_t kHeaderSize = 64;
+constexpr size_t kEntrySize = 32;
+constexpr size_t kAlignment = 64;
+/*
+ * Elements are written in chunks of this size.
+ */
+constexpr size_t kChunkSize = 4096;
+
+uint32_t elementSize(SectionType type) {
+  switch (type) {
+  case SectionType::kLongitudes:
+  case SectionType::kLatitudes:
+  case SectionType::kPackedTileIds:
+    return 4;
+  case SectionType::kMortonCodes:
+    return 8;
+  }
+  return 0;
+}
+
+void putU32(uint8_t *out, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    out[i] = (uint8_t)(v >> 8 * i);
+  }
+}
+
+void putU64(uint8_t *out, uint64_t v) {
+  putU32(out, (uint32_t)v);
+  putU32(out + 4, (uint32_t)(v >> 32));
+}
+
+uint32_t getU32(const uint8_t *in) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++) {
+    v |= (uint32_t)in[i] << 8 * i;
+  }
+  return v;
+}
+
+uint64_t getU64(const uint8_t *in) {
+  return getU32(in) | (uint64_t)getU32(in + 4) << 32;
+}
+} // namespace
+
+BinaryFileWriter::BinaryFileWriter(const std::string &path)
+    : out_(path, std::ios::binary | std::ios::trunc) {
+  /* The header is written by finish(), once the table offset is known. */
+  const char header[kHeaderSize] = {};
+  write(header, sizeof(header));
+}
+
+BinaryFileWriter::~BinaryFileWriter() { finish(); }
+
+void BinaryFileWriter::beginSection(SectionType type, int level) {
+  const char padding[kAlignment] = {};
+  write(padding, (kAlignment - offset_ % kAlignment) % kAlignment);
+  sections_.push_back({type, level, offset_, 0});
+}
+
+void BinaryFileWriter::write(const void *data, size_t size) {
+  out_.write(static_cast<const char *>(data), (std::streamsize)size);
+  offset_ += size;
+}
+
+void BinaryFileWriter::endSection(uint64_t count) {
+  sections_.back().count = count;
+}
+
+void BinaryFileWriter::addCoordinates(const int32_t *ndsLon,
+                                      const int32_t *ndsLat, size_t count) {
+  if (finished_) {
+    return;
+  }
+  beginSection(SectionType::kLongitudes, -1);
+  write(ndsLon, count * sizeof(int32_t));
+  endSection(count);
+  beginSection(SectionType::kLatitudes, -1);
+  write(ndsLat, count * sizeof(int32_t));
+  endSection(count);
+}
+
+void BinaryFileWriter::addCoordinates(
+    const std::vector<NdsCoordinate> &coords) {
+  if (finished_) {
+    return;
+  }
+  int32_t chunk[kChunkSize];
+  for (SectionType type : {SectionType::kLongitudes, SectionType::kLatitudes}) {
+    beginSection(type, -1);
+    for (size_t i = 0; i < coords.size(); i += kChunkSize) {
+      size_t n = std::min(kChunkSize, coords.size() - i);
+      for (size_t j = 0; j < n; j++) {
+        chunk[j] = type == SectionType::kLongitudes ? coords[i + j].longitude()
+                                                    : coords[i + j].latitude();
+      }
+      write(chunk, n * sizeof(int32_t));
+    }
+    endSection(coords.size());
+  }
+}
+
+void BinaryFileWriter::addMortonCodes(const int64_t *codes, size_t count) {
+  if (finished_) {
+    return;
+  }
+  beginSection(SectionType::kMortonCodes, -1);
+  write(codes, count * sizeof(int64_t));
+  endSection(count);
+}
+
+void BinaryFileWriter::addPackedTileIds(const int32_t *packedIds,
+                                        size_t count, int level) {
+  if (level < -1 || level > kMaxLevel) {
+    LOG(FATAL) << "The Tile level " << level << " exceeds the range [-1, 15].";
+  }
+  if (finished_) {
+    return;
+  }
+  beginSection(SectionType::kPackedTileIds, level);
+  write(packedIds, count * sizeof(int32_t));
+  endSection(count);
+}
+
+void BinaryFileWriter::addTileSet(const TileSet &tiles) {
+  if (finished_) {
+    return;
+  }
+  int32_t chunk[kChunkSize];
+  for (int level = 0; level <= kMaxLevel; level++) {
+    if (tiles.level(level).empty()) {
+      continue;
+    }
+    beginSection(SectionType::kPackedTileIds, level);
+    size_t n = 0;
+    uint64_t count = 0;
+    tiles.level(level).forEach([&](int nr) {
+      chunk[n++] = NdsTile(level, nr).packedId();
+      if (n == kChunkSize) {
+        write(chunk, sizeof(chunk));
+        count += n;
+        n = 0;
+      }
+    });
+    write(chunk, n * sizeof(int32_t));
+    endSection(count + n);
+  }
+}
+
+Status BinaryFileWriter::finish() {
+  if (!finished_) {
+    finished_ = true;
+    uint64_t tableOffset = offset_;
+    std::vector<uint8_t> table(sections_.size() * kEntrySize);
+    for (size_t i = 0; i < sections_.size(); i++) {
+      const BinarySection &s = sections_[i];
+      uint8_t *entry = table.data() + i * kEntrySize;
+      putU32(entry, (uint32_t)s.type);
+      putU32(entry + 4, (uint32_t)s.level);
+      putU32(entry + 8, elementSize(s.type));
+      putU64(entry + 16, s.offset);
+      putU64(entry + 24, s.count);
+    }
+    write(table.data(), table.size());
+
+    uint8_t header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    putU32(header + 4, kVersion);
+    putU64(header + 8, tableOffset);
+    putU32(header + 16, (uint32_t)sections_.size());
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out_.close();
+  }
+  return out_.fail() ? Status::kIoError : Status::kOk;
+}
+
+Result<BinaryFile> BinaryFile::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return Status::kIoError;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return Status::kIoError;
+  }
+  if ((size_t)st.st_size < kHeaderSize) {
+    ::close(fd);
+    return Status::kInvalidData;
+  }
+  void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return Status::kIoError;
+  }
+  Result<BinaryFile> file =
+      parse(static_cast<const uint8_t *>(data), (size_t)st.st_size);
+  if (!file) {
+    munmap(data, (size_t)st.st_size);
+    return file.status();
+  }
+  file.value().mapped_ = true;
+  return file;
+}
+
+Result<BinaryFile> BinaryFile::parse(const uint8_t *data, size_t size) {
+  // The arrays are read in place, which requires 8 byte aligned data.
+  if (reinterpret_cast<uintptr_t>(data) % 8 != 0 || size < kHeaderSize ||
+      std::memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      getU32(data + 4) != BinaryFileWriter::kVersion) {
+    return Status::kInvalidData;
+  }
+  uint64_t tableOffset = getU64(data + 8);
+  uint64_t count = getU32(data + 16);
+  if (tableOffset < kHeaderSize || tableOffset > size ||
+      count > (size - tableOffset) / kEntrySize) {
+    return Status::kInvalidData;
+  }
+  BinaryFile file;
+  file.data_ = data;
+  file.size_ = size;
+  for (uint64_t i = 0; i < count; i++) {
+    const uint8_t *entry = data + tableOffset + i * kEntrySize;
+    BinarySection s;
+    s.type = (SectionType)getU32(entry);
+    s.level = (int32_t)getU32(entry + 4);
+    s.offset = getU64(entry + 16);
+    s.count = getU64(entry + 24);
+    uint32_t width = elementSize(s.type);
+    /* The sections lie between header and table. */
+    if (width == 0 || getU32(entry + 8) != width || s.level < -1 ||
+        s.level > kMaxLevel || s.offset % kAlignment != 0 ||
+        s.offset < kHeaderSize || s.offset > tableOffset ||
+        s.count > (tableOffset - s.offset) / width) {
+      return Status::kInvalidData;
+    }
+    file.sections_.push_back(s);
+  }
+  return file;
+}
+
+BinaryFile::BinaryFile(BinaryFile &&other) noexcept
+    : data_(other.data_), size_(other.size_), mapped_(other.mapped_),
+      sections_(std::move(other.sections_)) {
+  other.data_ = nullptr;
+  other.mapped_ = false;
+}
+
+BinaryFile &BinaryFile::operator=(BinaryFile &&other) noexcept {
+  if (this != &other) {
+    unmap();
+    data_ = other.data_;
+    size_ = other.size_;
+    mapped_ = other.mapped_;
+    sections_ = std::move(other.sections_);
+    other.data_ = nullptr;
+    other.mapped_ = false;
+  }
+  return *this;
+}
+
+BinaryFile::~BinaryFile() { unmap(); }
+
+void BinaryFile::unmap() {
+  if (mapped_) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+    mapped_ = false;
+  }
+}
+
+const BinarySection *BinaryFile::find(SectionType type, int level) const {
+  for (const BinarySection &s : sections_) {
+    if (s.type == type && s.level == level) {
+      return &s;
+    }
+  }
+  return nullptr;
+}
+
+Span<int32_t> BinaryFile::int32s(const BinarySection &section) const {
+  if (elementSize(section.type) != sizeof(int32_t)) {
+    LOG(FATAL) << "Section type " << (uint32_t)section.type
+               << " has no 32 bit elements.";
+  }
+  return {reinterpret_cast<const int32_t *>(data_ + section.offset),
+          (size_t)section.count};
+}
+
+Span<int64_t> BinaryFile::int64s(const BinarySection &section) const {
+  if (elementSize(section.type) != sizeof(int64_t)) {
+    LOG(FATAL) << "Section type " << (uint32_t)section.type
+               << " has no 64 bit elements.";
+  }
+  return {reinterpret_cast<const int64_t *>(data_ + section.offset),
+          (size_t)section.count};
+}
+
+Span<int32_t> BinaryFile::longitudes() const {
+  const BinarySection *s = find(SectionType::kLongitudes);
+  return s != nullptr ? int32s(*s) : Span<int32_t>();
+}
+
+Span<int32_t> BinaryFile::latitudes() const {
+  const BinarySection *s = find(SectionType::kLatitudes);
+  return s != nullptr ? int32s(*s) : Span<int32_t>();
+}
+
+Span<int64_t> BinaryFile::mortonCodes() const {
+  const BinarySection *s = find(SectionType::kMortonCodes);
+  return s != nullptr ? int64s(*s) : Span<int64_t>();
+}
+
+Span<int32_t> BinaryFile::packedTileIds(int level) const {
+  const BinarySection *s = find(SectionType::kPackedTileIds, level);
+  return s != nullptr ? int32s(*s) : Span<int32_t>();
+}
+
+} // namespace nds
@@ -0,0 +1,312 @@
+#include "nds/nds_geojson.h"
+//
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace nds {
+namespace geojson {
+namespace {
+/*
+ * The constant parts of the features.
+ */
+constexpr char kGeometry[] = "{\"geometry\":{\"coordinates\":[";
+constexpr char kPointEnd[] = "],\"type\":\"Point\"},\"properties\":";
+constexpr char kPolygonEnd[] = "],\"type\":\"Polygon\"},\"properties\":";
+constexpr char kNull[] = "null";
+constexpr char kFeatureEnd[] = ",\"type\":\"Feature\"}";
+constexpr char kCollectionBegin[] = "{\"features\":[";
+constexpr char kCollectionEnd[] = "],\"type\":\"FeatureCollection\"}";
+
+/*
+ * The maximum length of the tile properties, e.g.
+ * {"count":-9223372036854775808,"level":15,"packedId":-2147483648,...}.
+ */
+constexpr size_t kMaxPropertiesSize = 128;
+constexpr size_t kMaxFeatureSize = kMaxPolygonSize + kMaxPropertiesSize;
+
+/*
+ * Larger numbers are written in the shortest representation also with fixed
+ * decimals, so they fit into kMaxNumberSize.
+ */
+constexpr double kMaxFixed = 1e15;
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+template <size_t N> char *writeLiteral(const char (&text)[N], char *out) {
+  std::memcpy(out, text, N - 1);
+  return out + N - 1;
+}
+
+char *writePosition(double lon, double lat, int decimals, char *out) {
+  *out++ = '[';
+  out = writeNumber(lon, out, decimals);
+  *out++ = ',';
+  out = writeNumber(lat, out, decimals);
+  *out++ = ']';
+  return out;
+}
+
+char *writeInteger(int64_t value, char *out) {
+#if defined(__cpp_lib_to_chars)
+  return std::to_chars(out, out + 20, value).ptr;
+#else
+  return out + std::snprintf(out, 21, "%lld", (long long)value);
+#endif
+}
+
+/*
+ * Writes the geometry up to the "properties" member.
+ */
+char *writePointGeometry(const Wgs84Coordinate &coord, int decimals,
+                         char *out) {
+  out = writeLiteral(kGeometry, out);
+  out = writePosition(coord.longitude(), coord.latitude(), decimals, out);
+  return writeLiteral(kPointEnd, out);
+}
+
+char *writePolygonGeometry(const Wgs84Bbox &bbox, int decimals, char *out) {
+  out = writeLiteral(kGeometry, out);
+  out = writePosition(bbox.west(), bbox.south(), decimals, out);
+  *out++ = ',';
+  out = writePosition(bbox.east(), bbox.south(), decimals, out);
+  *out++ = ',';
+  out = writePosition(bbox.east(), bbox.north(), decimals, out);
+  *out++ = ',';
+  out = writePosition(bbox.west(), bbox.north(), decimals, out);
+  *out++ = ',';
+  out = writePosition(bbox.west(), bbox.south(), decimals, out);
+  return writeLiteral(kPolygonEnd, out);
+}
+
+template <size_t N>
+char *writeProperty(const char (&name)[N], int64_t value, bool *first,
+                    char *out) {
+  *out++ = *first ? '{' : ',';
+  *first = false;
+  out = writeLiteral(name, out);
+  return writeInteger(value, out);
+}
+
+/*
+ * Writes the selected properties of the tile in alphabetical order, or null.
+ */
+char *writeTileProperties(const NdsTile &tile, int properties,
+                          const int64_t *count, char *out) {
+  bool first = true;
+  if (count != nullptr) {
+    out = writeProperty("\"count\":", *count, &first, out);
+  }
+  if (properties & kLevel) {
+    out = writeProperty("\"level\":", tile.level(), &first, out);
+  }
+  if (properties & kPackedId) {
+    out = writeProperty("\"packedId\":", tile.packedId(), &first, out);
+  }
+  if (properties & kTileNumber) {
+    out = writeProperty("\"tileNumber\":", tile.tileNumber(), &first, out);
+  }
+  if (first) {
+    return writeLiteral(kNull, out);
+  }
+  *out++ = '}';
+  return out;
+}
+
+char *writeTileFeature(const NdsTile &tile, int properties,
+                       const int64_t *count, int decimals, char *out) {
+  out = writePolygonGeometry(tile.getBBox().toWGS84(), decimals, out);
+  out = writeTileProperties(tile, properties, count, out);
+  return writeLiteral(kFeatureEnd, out);
+}
+
+static_assert(sizeof(kGeometry) + sizeof(kPointEnd) + sizeof(kNull) +
+                      sizeof(kFeatureEnd) <=
+                  96,
+              "kMaxPointSize too small");
+static_assert(sizeof(kGeometry) + sizeof(kPolygonEnd) + sizeof(kNull) +
+                      sizeof(kFeatureEnd) <=
+                  96,
+              "kMaxPolygonSize too small");
+} // namespace
+
+char *writeNumber(double value, char *out, int decimals) {
+  char *begin = out;
+  bool fixed = decimals >= 0 && std::fabs(value) < kMaxFixed;
+  decimals = std::min(decimals, kMaxDecimals);
+#if defined(__cpp_lib_to_chars)
+  // Locale independent, and the shortest representation is the one of Ryu.
+  if (fixed) {
+    out = std::to_chars(out, out + kMaxNumberSize, value,
+                        std::chars_format::fixed, decimals)
+              .ptr;
+  } else {
+    out = std::to_chars(out, out + kMaxNumberSize, value).ptr;
+  }
+#else
+  if (fixed) {
+    out += std::snprintf(out, kMaxNumberSize, "%.*f", decimals, value);
+  } else {
+    // The fewest significant digits that read back as the same value.
+    for (int p = 15; p <= 17; p++) {
+      out = begin + std::snprintf(begin, kMaxNumberSize, "%.*g", p, value);
+      if (std::strtod(begin, nullptr) == value) {
+        break;
+      }
+    }
+  }
+#endif
+  if (fixed && decimals > 0) {
+    // Drop trailing zeros, but keep one decimal.
+    while (out[-1] == '0' && out[-2] != '.') {
+      out--;
+    }
+  }
+  // Integral values get a ".0" suffix, so they are read back as float.
+  if (std::all_of(begin, out, [](char c) { return c == '-' || isDigit(c); })) {
+    *out++ = '.';
+    *out++ = '0';
+  }
+  return out;
+}
+
+size_t writePoint(const Wgs84Coordinate &coord, char *out, int decimals) {
+  char *end = writePointGeometry(coord, decimals, out);
+  end = writeLiteral(kNull, end);
+  end = writeLiteral(kFeatureEnd, end);
+  return end - out;
+}
+
+void writePoint(const Wgs84Coordinate &coord, std::string *out,
+                int decimals) {
+  char buffer[kMaxPointSize];
+  out->append(buffer, writePoint(coord, buffer, decimals));
+}
+
+void writePoint(const Wgs84Coordinate &coord, std::ostream &out,
+                int decimals) {
+  char buffer[kMaxPointSize];
+  out.write(buffer, writePoint(coord, buffer, decimals));
+}
+
+size_t writePolygon(const Wgs84Bbox &bbox, char *out, int decimals) {
+  char *end = writePolygonGeometry(bbox, decimals, out);
+  end = writeLiteral(kNull, end);
+  end = writeLiteral(kFeatureEnd, end);
+  return end - out;
+}
+
+void writePolygon(const Wgs84Bbox &bbox, std::string *out, int decimals) {
+  char buffer[kMaxPolygonSize];
+  out->append(buffer, writePolygon(bbox, buffer, decimals));
+}
+
+void writePolygon(const Wgs84Bbox &bbox, std::ostream &out, int decimals) {
+  char buffer[kMaxPolygonSize];
+  out.write(buffer, writePolygon(bbox, buffer, decimals));
+}
+
+size_t writeTile(const NdsTile &tile, char *out, int decimals) {
+  return writePolygon(tile.getBBox().toWGS84(), out, decimals);
+}
+
+void writeTile(const NdsTile &tile, std::string *out, int decimals) {
+  writePolygon(tile.getBBox().toWGS84(), out, decimals);
+}
+
+void writeTile(const NdsTile &tile, std::ostream &out, int decimals) {
+  writePolygon(tile.getBBox().toWGS84(), out, decimals);
+}
+
+FeatureCollectionWriter::FeatureCollectionWriter(std::ostream &out,
+                                                 int tileProperties,
+                                                 size_t chunkSize, int decimals)
+    : out_(out), tileProperties_(tileProperties), chunkSize_(chunkSize),
+      decimals_(decimals), buffer_(chunkSize + kMaxFeatureSize) {
+  used_ = writeLiteral(kCollectionBegin, buffer_.data()) - buffer_.data();
+}
+
+FeatureCollectionWriter::~FeatureCollectionWriter() { finish(); }
+
+void FeatureCollectionWriter::writeChunk() {
+  if (used_ >= chunkSize_) {
+    out_.write(buffer_.data(), used_);
+    used_ = 0;
+  }
+}
+
+char *FeatureCollectionWriter::beginFeature() {
+  writeChunk();
+  char *out = buffer_.data() + used_;
+  if (size_ > 0) {
+    *out++ = ',';
+  }
+  return out;
+}
+
+void FeatureCollectionWriter::endFeature(char *end) {
+  used_ = end - buffer_.data();
+  size_++;
+}
+
+void FeatureCollectionWriter::add(const Wgs84Coordinate &coord) {
+  if (!finished_) {
+    char *out = beginFeature();
+    endFeature(out + writePoint(coord, out, decimals_));
+  }
+}
+
+void FeatureCollectionWriter::add(const Wgs84Bbox &bbox) {
+  if (!finished_) {
+    char *out = beginFeature();
+    endFeature(out + writePolygon(bbox, out, decimals_));
+  }
+}
+
+void FeatureCollectionWriter::add(const NdsTile &tile) {
+  if (!finished_) {
+    endFeature(writeTileFeature(tile, tileProperties_, nullptr, decimals_,
+                                beginFeature()));
+  }
+}
+
+void FeatureCollectionWriter::add(const NdsTile &tile, int64_t count) {
+  if (!finished_) {
+    endFeature(writeTileFeature(tile, tileProperties_, &count, decimals_,
+                                beginFeature()));
+  }
+}
+
+void FeatureCollectionWriter::add(int level, const TileRange &range) {
+  for (int64_t nr = range.first; nr <= range.last; nr++) {
+    add(NdsTile(level, (int)nr));
+  }
+}
+
+void FeatureCollectionWriter::add(const TileSet &tiles) {
+  tiles.forEach([this](const NdsTile &tile) { add(tile); });
+}
+
+void FeatureCollectionWriter::flush() {
+  out_.write(buffer_.data(), used_);
+  used_ = 0;
+  out_.flush();
+}
+
+Status FeatureCollectionWriter::finish() {
+  if (!finished_) {
+    finished_ = true;
+    writeChunk();
+    used_ = writeLiteral(kCollectionEnd, buffer_.data() + used_) -
+            buffer_.data();
+    flush();
+  }
+  return out_.fail() ? Status::kIoError : Status::kOk;
+}
+
+} // namespace geojson
+} // namespace nds
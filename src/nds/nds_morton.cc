@@ -0,0 +1,136 @@
+#include "nds/nds_morton.h"
+//
+#include "cpu_features.h"
+#ifdef NDS_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace nds {
+namespace morton {
+namespace {
+constexpr uint64_t kLongitudeMask = 0x5555555555555555ULL;
+constexpr uint64_t kLatitudeMask = 0x2AAAAAAAAAAAAAAAULL;
+
+using EncodeFn = int64_t (*)(int32_t, int32_t);
+using DecodeFn = void (*)(int64_t, int32_t *, int32_t *);
+
+int64_t encodePortableFn(int32_t longitude, int32_t latitude) {
+  return encodePortable(longitude, latitude);
+}
+
+void decodePortableFn(int64_t code, int32_t *longitude, int32_t *latitude) {
+  decodePortable(code, longitude, latitude);
+}
+
+#ifdef NDS_X86_DISPATCH
+__attribute__((target("bmi2"))) int64_t encodeBmi2Impl(int32_t longitude,
+                                                       int32_t latitude) {
+  uint64_t res = _pdep_u64((uint32_t)longitude, kLongitudeMask) |
+                 _pdep_u64((uint32_t)latitude & 0x7FFFFFFFu, kLatitudeMask);
+  if (latitude < 0) {
+    res |= 1ULL << 61;
+  }
+  return (int64_t)res;
+}
+
+__attribute__((target("bmi2"))) void
+decodeBmi2Impl(int64_t code, int32_t *longitude, int32_t *latitude) {
+  uint32_t lat = (uint32_t)_pext_u64((uint64_t)code, kLatitudeMask);
+  lat |= (lat & 0x40000000u) << 1;
+  *longitude = (int32_t)_pext_u64((uint64_t)code, kLongitudeMask);
+  *latitude = (int32_t)lat;
+}
+#endif
+
+struct Engine {
+  EncodeFn encode;
+  DecodeFn decode;
+};
+
+Engine selectEngine() {
+#ifdef NDS_X86_DISPATCH
+  if (cpu::hasFastBmi2()) {
+    return {encodeBmi2Impl, decodeBmi2Impl};
+  }
+#endif
+  return {encodePortableFn, decodePortableFn};
+}
+
+const Engine &engine() {
+  static const Engine selected = selectEngine();
+  return selected;
+}
+} // namespace
+
+int64_t encodeReference(int32_t longitude, int32_t latitude) {
+  int64_t res = 0L;
+  for (int pos = 0; pos < 31; pos++) {
+    if ((longitude & 1 << pos) > 0) {
+      res |= 1L << (2 * pos);
+    }
+    if (pos < 31 && (latitude & 1 << pos) > 0) {
+      res |= 1L << (2 * pos + 1);
+    }
+  }
+  if (longitude < 0) {
+    res |= 1L << 62;
+  }
+  // For 31-bit signed integers the 32st bit needs to be copied to the 31st bit
+  // in case of negative numbers.
+  if (latitude < 0) {
+    res |= 1L << 61;
+  }
+  return res;
+}
+
+void decodeReference(int64_t code, int32_t *longitude, int32_t *latitude) {
+  int lat = 0;
+  int lon = 0;
+  for (int pos = 0; pos < 32; ++pos) {
+    if (pos < 31 && (code & 1L << (pos * 2 + 1)) != 0L) {
+      lat |= 1 << pos;
+    }
+    if ((code & 1L << (pos * 2)) != 0L) {
+      lon |= 1 << pos;
+    }
+  }
+  /*
+   * with NDS, the latitude value is considered a 31-bit signed integer.
+   * hence, if the 31st bit is 1, this means we have a negative integer,
+   * requiring to set the 32st bit to 1 for native java 32bit signed integers.
+   */
+  if ((lat & 1 << 30) > 0) {
+    lat |= 1 << 31;
+  }
+  *longitude = lon;
+  *latitude = lat;
+}
+
+bool bmi2Supported() { return engine().encode != encodePortableFn; }
+
+int64_t encodeBmi2(int32_t longitude, int32_t latitude) {
+#ifdef NDS_X86_DISPATCH
+  return encodeBmi2Impl(longitude, latitude);
+#else
+  return encodePortable(longitude, latitude);
+#endif
+}
+
+void decodeBmi2(int64_t code, int32_t *longitude, int32_t *latitude) {
+#ifdef NDS_X86_DISPATCH
+  decodeBmi2Impl(code, longitude, latitude);
+#else
+  decodePortable(code, longitude, latitude);
+#endif
+}
+
+int64_t encode(int32_t longitude, int32_t latitude) {
+  return engine().encode(longitude, latitude);
+}
+
+void decode(int64_t code, int32_t *longitude, int32_t *latitude) {
+  engine().decode(code, longitude, latitude);
+}
+
+} // namespace morton
+} // namespace nds
@@ -0,0 +1,111 @@
+#include "nds/nds_morton_index.h"
+//
+#include "nds/nds_batch.h"
+#include "nds/nds_tile_cover.h"
+#include <algorithm>
+
+namespace nds {
+namespace {
+/*
+ * The largest level at which the bounding box spans at most 5 tiles in each
+ * direction, which keeps the number of Morton ranges small while the tiles
+ * add little area beyond the box.
+ */
+int queryLevel(const NdsBbox &bbox) {
+  // Unsigned, so boxes across the antimeridian wrap instead of overflowing.
+  int64_t width = (int64_t)((uint32_t)bbox.east() - (uint32_t)bbox.west()) + 1;
+  int64_t height = (int64_t)bbox.north() - bbox.south() + 1;
+  int64_t extent = std::max(width, height);
+  int level = kMaxLevel;
+  while (level > 0 && (4LL << (31 - level)) < extent) {
+    level--;
+  }
+  return level;
+}
+
+bool contains(const NdsBbox &bbox, const NdsCoordinate &c) {
+  if (c.latitude() < bbox.south() || bbox.north() < c.latitude()) {
+    return false;
+  }
+  if (bbox.west() <= bbox.east()) {
+    return bbox.west() <= c.longitude() && c.longitude() <= bbox.east();
+  }
+  return bbox.west() <= c.longitude() || c.longitude() <= bbox.east();
+}
+} // namespace
+
+MortonIndex::MortonIndex(std::vector<MortonRecord> records) {
+  build(&records);
+}
+
+MortonIndex::MortonIndex(const int32_t *ndsLon, const int32_t *ndsLat,
+                         const uint64_t *payloads, size_t count) {
+  std::vector<int64_t> codes(count);
+  encodeMortonCodes(ndsLon, ndsLat, count, codes.data());
+  std::vector<MortonRecord> records(count);
+  for (size_t i = 0; i < count; i++) {
+    records[i] = {codes[i], payloads[i]};
+  }
+  build(&records);
+}
+
+void MortonIndex::build(std::vector<MortonRecord> *records) {
+  std::stable_sort(records->begin(), records->end(),
+                   [](const MortonRecord &a, const MortonRecord &b) {
+                     return a.morton < b.morton;
+                   });
+  codes_.resize(records->size());
+  payloads_.resize(records->size());
+  for (size_t i = 0; i < records->size(); i++) {
+    codes_[i] = (*records)[i].morton;
+    payloads_[i] = (*records)[i].payload;
+  }
+}
+
+IndexRange MortonIndex::find(int64_t firstMorton, int64_t lastMorton) const {
+  auto first = std::lower_bound(codes_.begin(), codes_.end(), firstMorton);
+  auto last = std::upper_bound(first, codes_.end(), lastMorton);
+  return {(size_t)(first - codes_.begin()), (size_t)(last - codes_.begin())};
+}
+
+IndexRange MortonIndex::find(const NdsTile &tile) const {
+  int64_t first = tile.southWestAsMorton();
+  return find(first, first | ((1LL << mortonShift(tile.level())) - 1));
+}
+
+std::vector<IndexRange> MortonIndex::candidates(const NdsBbox &bbox) const {
+  std::vector<IndexRange> ranges;
+  if (bbox.south() > bbox.north() || codes_.empty()) {
+    return ranges;
+  }
+  const int level = queryLevel(bbox);
+  const int shift = mortonShift(level);
+  auto begin = codes_.begin();
+  for (const TileRange &tiles : coverRanges(bbox, level)) {
+    int64_t first = (int64_t)tiles.first << shift;
+    int64_t last = (int64_t)tiles.last << shift | ((1LL << shift) - 1);
+    // The tile ranges are sorted, so each search continues from the last.
+    begin = std::lower_bound(begin, codes_.end(), first);
+    auto end = std::upper_bound(begin, codes_.end(), last);
+    if (begin != end) {
+      ranges.push_back({(size_t)(begin - codes_.begin()),
+                        (size_t)(end - codes_.begin())});
+    }
+    begin = end;
+  }
+  return ranges;
+}
+
+std::vector<size_t> MortonIndex::query(const NdsBbox &bbox) const {
+  std::vector<size_t> positions;
+  for (const IndexRange &range : candidates(bbox)) {
+    for (size_t i = range.first; i < range.last; i++) {
+      if (contains(bbox, coordinate(i))) {
+        positions.push_back(i);
+      }
+    }
+  }
+  return positions;
+}
+
+} // namespace nds
@@ -0,0 +1,262 @@
+#include "nds/nds_morton_stream.h"
+//
+#include <glog/logging.h>
+//
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace nds {
+namespace {
+constexpr uint8_t kMagic[4] = {'N', 'D', 'M', 'S'};
+/*
+ * A 64 bit delta takes at most 10 varint bytes.
+ */
+constexpr size_t kMaxVarintSize = 10;
+/*
+ * Zero bytes after the last block for reading whole words.
+ */
+constexpr size_t kPadding = 8;
+
+void putVarint(std::vector<uint8_t> *out, uint64_t v) {
+  while (v >= 0x80) {
+    out->push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out->push_back((uint8_t)v);
+}
+
+void putU32(std::vector<uint8_t> *out, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    out->push_back((uint8_t)(v >> 8 * i));
+  }
+}
+
+void putU64(std::vector<uint8_t> *out, uint64_t v) {
+  putU32(out, (uint32_t)v);
+  putU32(out, (uint32_t)(v >> 32));
+}
+
+uint64_t getU64(const uint8_t *in, int bytes) {
+  uint64_t v = 0;
+  for (int i = 0; i < bytes; i++) {
+    v |= (uint64_t)in[i] << 8 * i;
+  }
+  return v;
+}
+
+/*
+ * Decodes count - 1 deltas of valid data, the bounds were checked by the
+ * encoder or deserialize(). The data is followed by kPadding bytes, so
+ * varints are read eight bytes at a time: the first clear high bit ends the
+ * varint, and the 7 bit groups are compacted without branches.
+ */
+void decodeDeltas(const uint8_t *in, int64_t first, size_t count,
+                  int64_t *out) {
+  uint64_t code = (uint64_t)first;
+  out[0] = first;
+  for (size_t i = 1; i < count; i++) {
+    uint64_t word;
+    std::memcpy(&word, in, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    uint64_t stops = ~word & 0x8080808080808080ULL;
+    uint64_t delta = 0;
+    if (stops != 0) {
+      int bits = __builtin_ctzll(stops) + 1;
+      in += bits / 8;
+      word &= bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+      for (int g = 0; g < 8; g++) {
+        delta |= (word >> g) & (0x7FULL << 7 * g);
+      }
+    } else {
+      // 9 or 10 bytes, only for deltas of 2^56 and more.
+      int shift = 0;
+      uint8_t b;
+      do {
+        b = *in++;
+        delta |= (uint64_t)(b & 0x7F) << shift;
+        shift += 7;
+      } while (b & 0x80);
+    }
+    code += delta;
+    out[i] = (int64_t)code;
+  }
+}
+
+/*
+ * Reads a varint of at most kMaxVarintSize bytes that fits into 64 bits,
+ * returns false otherwise.
+ */
+bool readVarint(const uint8_t **in, const uint8_t *end, uint64_t *v) {
+  *v = 0;
+  for (size_t i = 0; i < kMaxVarintSize && *in < end; i++) {
+    uint8_t b = *(*in)++;
+    if (i == kMaxVarintSize - 1 && b > 1) {
+      return false;
+    }
+    *v |= (uint64_t)(b & 0x7F) << 7 * i;
+    if ((b & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+MortonStream::MortonStream(const std::vector<NdsCoordinate> &coords) {
+  std::vector<int64_t> codes(coords.size());
+  for (size_t i = 0; i < coords.size(); i++) {
+    codes[i] = coords[i].getMortonCode();
+  }
+  std::sort(codes.begin(), codes.end());
+  encode(codes.data(), codes.size());
+}
+
+MortonStream::MortonStream(const int64_t *codes, size_t count) {
+  if (!std::is_sorted(codes, codes + count)) {
+    LOG(FATAL) << "The Morton codes must be in ascending order.";
+  }
+  encode(codes, count);
+}
+
+void MortonStream::encode(const int64_t *codes, size_t count) {
+  size_ = count;
+  for (size_t i = 0; i < count; i++) {
+    if (i % kBlockSize == 0) {
+      firsts_.push_back(codes[i]);
+      offsets_.push_back(bytes_.size());
+    } else {
+      // Ascending codes have non-negative differences below 2^64.
+      putVarint(&bytes_, (uint64_t)codes[i] - (uint64_t)codes[i - 1]);
+    }
+  }
+  offsets_.push_back(bytes_.size());
+  bytes_.resize(bytes_.size() + kPadding);
+  bytes_.shrink_to_fit();
+}
+
+size_t MortonStream::decodeBlock(size_t block, int64_t *out) const {
+  size_t count = std::min(kBlockSize, size_ - block * kBlockSize);
+  decodeDeltas(bytes_.data() + offsets_[block], firsts_[block], count, out);
+  return count;
+}
+
+void MortonStream::decode(std::vector<int64_t> *out) const {
+  size_t begin = out->size();
+  out->resize(begin + size_);
+  for (size_t block = 0; block < firsts_.size(); block++) {
+    decodeBlock(block, out->data() + begin + block * kBlockSize);
+  }
+}
+
+void MortonStream::decode(std::vector<NdsCoordinate> *out) const {
+  int64_t codes[kBlockSize];
+  out->reserve(out->size() + size_);
+  for (size_t block = 0; block < firsts_.size(); block++) {
+    size_t count = decodeBlock(block, codes);
+    for (size_t i = 0; i < count; i++) {
+      out->emplace_back(codes[i]);
+    }
+  }
+}
+
+void MortonStream::find(int64_t firstMorton, int64_t lastMorton,
+                        std::vector<int64_t> *out) const {
+  /*
+   * The codes of the blocks before the last one starting below firstMorton
+   * are smaller than firstMorton. Blocks starting at firstMorton may be
+   * preceded by one ending with it.
+   */
+  size_t block =
+      std::lower_bound(firsts_.begin(), firsts_.end(), firstMorton) -
+      firsts_.begin();
+  block = block > 0 ? block - 1 : 0;
+  int64_t codes[kBlockSize];
+  for (; block < firsts_.size() && firsts_[block] <= lastMorton; block++) {
+    size_t count = decodeBlock(block, codes);
+    int64_t *first = std::lower_bound(codes, codes + count, firstMorton);
+    int64_t *last = std::upper_bound(first, codes + count, lastMorton);
+    out->insert(out->end(), first, last);
+  }
+}
+
+void MortonStream::find(const NdsTile &tile,
+                        std::vector<NdsCoordinate> *out) const {
+  int64_t first = tile.southWestAsMorton();
+  std::vector<int64_t> codes;
+  find(first, first | ((1LL << mortonShift(tile.level())) - 1), &codes);
+  for (int64_t code : codes) {
+    out->emplace_back(code);
+  }
+}
+
+void MortonStream::serialize(std::vector<uint8_t> *out) const {
+  out->insert(out->end(), std::begin(kMagic), std::end(kMagic));
+  putU64(out, size_);
+  for (size_t block = 0; block < firsts_.size(); block++) {
+    putU64(out, (uint64_t)firsts_[block]);
+    putU32(out, (uint32_t)(offsets_[block + 1] - offsets_[block]));
+    out->insert(out->end(), bytes_.begin() + offsets_[block],
+                bytes_.begin() + offsets_[block + 1]);
+  }
+}
+
+Result<MortonStream> MortonStream::deserialize(const uint8_t *data,
+                                               size_t size) {
+  const uint8_t *end = data + size;
+  if (size < sizeof(kMagic) + 8 ||
+      !std::equal(std::begin(kMagic), std::end(kMagic), data)) {
+    return Status::kInvalidData;
+  }
+  const uint8_t *in = data + sizeof(kMagic);
+  uint64_t count = getU64(in, 8);
+  in += 8;
+  // Every block takes at least 12 bytes.
+  uint64_t blocks = count / kBlockSize + (count % kBlockSize != 0);
+  if (blocks > (uint64_t)(end - in) / 12) {
+    return Status::kInvalidData;
+  }
+  MortonStream stream;
+  stream.size_ = count;
+  uint64_t code = 0;
+  for (uint64_t block = 0; block < blocks; block++) {
+    if (end - in < 12) {
+      return Status::kInvalidData;
+    }
+    int64_t first = (int64_t)getU64(in, 8);
+    uint64_t length = getU64(in + 8, 4);
+    in += 12;
+    if ((uint64_t)(end - in) < length || (block > 0 && first < (int64_t)code)) {
+      return Status::kInvalidData;
+    }
+    // The deltas must fill the block exactly and keep the codes in range.
+    const uint8_t *deltas = in;
+    in += length;
+    code = (uint64_t)first;
+    size_t n = std::min<uint64_t>(kBlockSize, count - block * kBlockSize);
+    for (size_t i = 1; i < n; i++) {
+      uint64_t delta = 0;
+      if (!readVarint(&deltas, in, &delta) ||
+          delta > (uint64_t)std::numeric_limits<int64_t>::max() - code) {
+        return Status::kInvalidData;
+      }
+      code += delta;
+    }
+    if (deltas != in) {
+      return Status::kInvalidData;
+    }
+    stream.firsts_.push_back(first);
+    stream.offsets_.push_back(stream.bytes_.size());
+    stream.bytes_.insert(stream.bytes_.end(), in - length, in);
+  }
+  if (in != end) {
+    return Status::kInvalidData;
+  }
+  stream.offsets_.push_back(stream.bytes_.size());
+  stream.bytes_.resize(stream.bytes_.size() + kPadding);
+  return stream;
+}
+
+} // namespace nds
@@ -0,0 +1,93 @@
+#include "nds/nds_packed_id_set.h"
+//
+#include <algorithm>
+
+namespace nds {
+namespace {
+/*
+ * Visits the positions 1..size of an Eytzinger tree in order, i.e. in the
+ * order of the sorted IDs.
+ */
+template <typename Fn> void forEachInOrder(size_t size, Fn fn) {
+  std::vector<size_t> stack;
+  size_t k = 1;
+  while (k <= size || !stack.empty()) {
+    while (k <= size) {
+      stack.push_back(k);
+      k = 2 * k;
+    }
+    k = stack.back();
+    stack.pop_back();
+    fn(k);
+    k = 2 * k + 1;
+  }
+}
+
+int countTrailingOnes(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return value == ~0ULL ? 64 : __builtin_ctzll(~value);
+#else
+  int n = 0;
+  for (; value & 1; value >>= 1) {
+    n++;
+  }
+  return n;
+#endif
+}
+} // namespace
+
+PackedIdSet::PackedIdSet(std::vector<int> packedIds) { build(&packedIds); }
+
+PackedIdSet::PackedIdSet(const std::vector<NdsTile> &tiles) {
+  std::vector<int> packedIds;
+  packedIds.reserve(tiles.size());
+  for (const NdsTile &tile : tiles) {
+    packedIds.push_back(tile.packedId());
+  }
+  build(&packedIds);
+}
+
+void PackedIdSet::build(std::vector<int> *packedIds) {
+  std::sort(packedIds->begin(), packedIds->end());
+  packedIds->erase(std::unique(packedIds->begin(), packedIds->end()),
+                   packedIds->end());
+  size_ = packedIds->size();
+  blocks_.assign((size_ + 1 + 15) / 16, Block());
+  if (size_ == 0) {
+    return;
+  }
+  int32_t *tree = blocks_.front().ids;
+  // An in-order traversal of the tree visits the IDs in ascending order.
+  size_t next = 0;
+  forEachInOrder(size_, [&](size_t k) { tree[k] = (*packedIds)[next++]; });
+}
+
+bool PackedIdSet::contains(int packedId) const {
+  if (size_ == 0) {
+    return false;
+  }
+  const int32_t *t = tree();
+  size_t k = 1;
+  while (k <= size_) {
+#if defined(__GNUC__) || defined(__clang__)
+    // The descendants four levels down, while they are within the tree.
+    if (16 * k <= size_) {
+      __builtin_prefetch(t + 16 * k);
+    }
+#endif
+    k = 2 * k + (t[k] < packedId);
+  }
+  // Cancel the right turns after the last left turn, which was taken at the
+  // smallest ID not less than packedId.
+  k >>= countTrailingOnes(k) + 1;
+  return k != 0 && t[k] == packedId;
+}
+
+std::vector<int> PackedIdSet::sorted() const {
+  std::vector<int> ids;
+  ids.reserve(size_);
+  forEachInOrder(size_, [&](size_t k) { ids.push_back(tree()[k]); });
+  return ids;
+}
+
+} // namespace nds
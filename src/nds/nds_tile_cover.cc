@@ -0,0 +1,558 @@
+#include "nds/nds_tile_cover.h"
+//
+#include "tile_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <glog/logging.h>
+
+namespace nds {
+namespace {
+/*
+ * An inclusive interval of unsigned grid columns or rows.
+ */
+struct Interval {
+  uint32_t lo;
+  uint32_t hi;
+};
+
+/*
+ * Maps the signed interval [lo, hi] to unsigned intervals with the given
+ * number of bits. Negative values are stored above the non-negative ones.
+ */
+void addInterval(int lo, int hi, int bits, std::vector<Interval> *out) {
+  const uint32_t mask = (uint32_t)((1ULL << bits) - 1);
+  if (lo < 0 && hi >= 0) {
+    out->push_back({0, (uint32_t)hi});
+    out->push_back({(uint32_t)lo & mask, mask});
+  } else {
+    out->push_back({(uint32_t)lo & mask, (uint32_t)hi & mask});
+  }
+}
+
+void normalize(std::vector<Interval> *intervals) {
+  std::sort(intervals->begin(), intervals->end(),
+            [](const Interval &a, const Interval &b) { return a.lo < b.lo; });
+  std::vector<Interval> merged;
+  for (const Interval &i : *intervals) {
+    if (!merged.empty() && (uint64_t)merged.back().hi + 1 >= i.lo) {
+      merged.back().hi = std::max(merged.back().hi, i.hi);
+    } else {
+      merged.push_back(i);
+    }
+  }
+  intervals->swap(merged);
+}
+
+/*
+ * 0: disjoint, 1: intersecting, 2: contained.
+ */
+int classify(const std::vector<Interval> &intervals, uint32_t lo,
+             uint32_t hi) {
+  for (const Interval &i : intervals) {
+    if (i.lo <= lo && hi <= i.hi) {
+      return 2;
+    }
+    if (i.lo <= hi && lo <= i.hi) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Appends a range, merging it with the last one if adjacent.
+ */
+void addRange(std::vector<TileRange> *ranges, int64_t first, int64_t last) {
+  if (!ranges->empty() && (int64_t)ranges->back().last + 1 == first) {
+    ranges->back().last = (int)last;
+  } else {
+    ranges->push_back({(int)first, (int)last});
+  }
+}
+
+class RangeCollector {
+public:
+  RangeCollector(const std::vector<Interval> &cols,
+                 const std::vector<Interval> &rows)
+      : cols_(cols), rows_(rows) {}
+
+  /*
+   * Visits the square cell of the given size in Morton order, firstTile
+   * being the tile number of its lower left corner.
+   */
+  void visit(uint32_t x, uint32_t y, uint32_t size, int64_t firstTile) {
+    int xClass = classify(cols_, x, x + size - 1);
+    int yClass = classify(rows_, y, y + size - 1);
+    if (xClass == 0 || yClass == 0) {
+      return;
+    }
+    if (xClass == 2 && yClass == 2) {
+      addRange(&ranges_, firstTile, firstTile + (int64_t)size * size - 1);
+      return;
+    }
+    uint32_t half = size / 2;
+    int64_t quarter = (int64_t)half * half;
+    visit(x, y, half, firstTile);
+    visit(x + half, y, half, firstTile + quarter);
+    visit(x, y + half, half, firstTile + 2 * quarter);
+    visit(x + half, y + half, half, firstTile + 3 * quarter);
+  }
+
+  std::vector<TileRange> &ranges() { return ranges_; }
+
+private:
+  const std::vector<Interval> &cols_;
+  const std::vector<Interval> &rows_;
+  std::vector<TileRange> ranges_;
+};
+
+void checkLevel(int level) {
+  if (level < 0 || level > kMaxLevel) {
+    LOG(FATAL) << "The Tile level " << level << " exceeds the range [0, 15].";
+  }
+}
+
+NdsBbox toNds(const Wgs84Bbox &bbox) {
+  NdsCoordinate ne(bbox.east(), bbox.north());
+  NdsCoordinate sw(bbox.west(), bbox.south());
+  return NdsBbox(ne.latitude(), ne.longitude(), sw.latitude(), sw.longitude());
+}
+
+int64_t countTiles(const std::vector<TileRange> &ranges) {
+  int64_t count = 0;
+  for (const TileRange &range : ranges) {
+    count += range.size();
+  }
+  return count;
+}
+
+/*
+ * Polygon edge in NDS coordinates. The products of coordinate differences
+ * exceed 64 bits, so the predicates use 128-bit arithmetic.
+ */
+struct Edge {
+  int64_t ax;
+  int64_t ay;
+  int64_t bx;
+  int64_t by;
+};
+
+/*
+ * Sign of the cross product (b - a) x (p - a).
+ */
+int side(const Edge &e, int64_t px, int64_t py) {
+  __int128 cross = (__int128)(e.bx - e.ax) * (py - e.ay) -
+                   (__int128)(e.by - e.ay) * (px - e.ax);
+  return (cross > 0) - (cross < 0);
+}
+
+bool intersects(const Edge &e, const grid::Rect &r) {
+  if (std::max(e.ax, e.bx) < r.west || std::min(e.ax, e.bx) > r.east ||
+      std::max(e.ay, e.by) < r.south || std::min(e.ay, e.by) > r.north) {
+    return false;
+  }
+  int s = side(e, r.west, r.south) + side(e, r.east, r.south) +
+          side(e, r.east, r.north) + side(e, r.west, r.north);
+  // Not intersecting only if all corners are strictly on the same side.
+  return s != 4 && s != -4;
+}
+
+/*
+ * Point in polygon test (even-odd rule, casting a ray to the east) with the
+ * edges bucketed by horizontal bands, so only the edges of one band are
+ * tested.
+ */
+class EdgeIndex {
+public:
+  explicit EdgeIndex(const std::vector<Edge> &edges) : edges_(edges) {
+    if (edges.empty()) {
+      return;
+    }
+    south_ = edges[0].ay;
+    int64_t north = edges[0].ay;
+    for (const Edge &e : edges) {
+      south_ = std::min({south_, e.ay, e.by});
+      north = std::max({north, e.ay, e.by});
+    }
+    size_t bands = std::min<size_t>(std::max<size_t>(edges.size() / 4, 1),
+                                    1 << 16);
+    bandHeight_ = (north - south_) / (int64_t)bands + 1;
+    bands_.resize(bands);
+    for (size_t i = 0; i < edges.size(); i++) {
+      const Edge &e = edges[i];
+      size_t first = band(std::min(e.ay, e.by));
+      size_t last = band(std::max(e.ay, e.by));
+      for (size_t b = first; b <= last; b++) {
+        bands_[b].push_back((uint32_t)i);
+      }
+    }
+  }
+
+  bool contains(int64_t px, int64_t py) const {
+    if (bands_.empty() || py < south_ ||
+        py >= south_ + bandHeight_ * (int64_t)bands_.size()) {
+      return false;
+    }
+    bool inside = false;
+    for (uint32_t i : bands_[band(py)]) {
+      const Edge &e = edges_[i];
+      if ((e.ay > py) == (e.by > py)) {
+        continue;
+      }
+      // Is the intersection with the horizontal line east of the point?
+      __int128 lhs = (__int128)(px - e.ax) * (e.by - e.ay);
+      __int128 rhs = (__int128)(py - e.ay) * (e.bx - e.ax);
+      if (e.by > e.ay ? lhs < rhs : lhs > rhs) {
+        inside = !inside;
+      }
+    }
+    return inside;
+  }
+
+private:
+  size_t band(int64_t y) const { return (size_t)((y - south_) / bandHeight_); }
+
+  const std::vector<Edge> &edges_;
+  int64_t south_ = 0;
+  int64_t bandHeight_ = 1;
+  std::vector<std::vector<uint32_t>> bands_;
+};
+
+class PolygonCoverer {
+public:
+  PolygonCoverer(const std::vector<Edge> &edges, int level)
+      : edges_(edges), index_(edges), level_(level) {}
+
+  /*
+   * Classifies the tile and its descendants, edgeIds being the edges which
+   * intersect the parent tile.
+   */
+  void visit(int level, int nr, const std::vector<uint32_t> &edgeIds) {
+    grid::Rect rect = grid::area(nr, level);
+    std::vector<uint32_t> inside;
+    for (uint32_t i : edgeIds) {
+      if (intersects(edges_[i], rect)) {
+        inside.push_back(i);
+      }
+    }
+    int shift = 2 * (level_ - level);
+    int64_t first = (int64_t)nr << shift;
+    int64_t last = (((int64_t)nr + 1) << shift) - 1;
+    if (inside.empty()) {
+      // No edge touches the tile, so its center decides for all of it.
+      if (index_.contains((rect.west + rect.east) / 2,
+                          (rect.south + rect.north) / 2)) {
+        addRange(&cover_.interior, first, last);
+      }
+      return;
+    }
+    if (level == level_) {
+      addRange(&cover_.boundary, first, last);
+      return;
+    }
+    for (int child = 0; child < 4; child++) {
+      visit(level + 1, nr * 4 + child, inside);
+    }
+  }
+
+  PolygonCover &cover() { return cover_; }
+
+private:
+  const std::vector<Edge> &edges_;
+  EdgeIndex index_;
+  int level_;
+  PolygonCover cover_;
+};
+
+/*
+ * Meters per degree latitude (and longitude at the equator), derived from
+ * the WGS84 equatorial circumference. NDS coordinate units have the same
+ * size along longitude and latitude.
+ */
+constexpr double kMetersPerDegree = 40075016.686 / 360.0;
+constexpr double kUnitsPerDegree = (double)kLatitudeRange / 180.0;
+
+int64_t floorDiv(__int128 a, int64_t b) {
+  __int128 q = a / b;
+  if (a % b != 0 && (a < 0) != (b < 0)) {
+    q--;
+  }
+  return (int64_t)q;
+}
+
+int clampLatitude(int64_t lat) {
+  return (int)std::min<int64_t>(std::max<int64_t>(lat, kMinLatitude),
+                                kMaxLatitude);
+}
+
+/*
+ * Adds the tiles of a row from column first to last. Columns beyond the
+ * antimeridian wrap around, as tileNumber() keeps only the column bits.
+ */
+void addRow(int64_t first, int64_t last, int row, int level,
+            std::vector<int> *tiles) {
+  const int64_t columns = 1LL << grid::columnBits(level);
+  if (last - first + 1 >= columns) {
+    first = grid::minColumn(level);
+    last = grid::maxColumn(level);
+  }
+  for (int64_t col = first; col <= last; col++) {
+    tiles->push_back(grid::tileNumber((int)col, row, level));
+  }
+}
+
+/*
+ * Adds the tiles touched by the segment swept by the box [-bufferX, bufferX]
+ * x [-bufferY, bufferY]. Row by row, the segment points within the buffered
+ * row give the interval of columns, so diagonal steps through tile corners
+ * add both neighbors like a supercover traversal. Columns beyond the
+ * antimeridian wrap around.
+ */
+void coverSegment(NdsCoordinate a, NdsCoordinate b, int64_t bufferX,
+                  int64_t bufferY, int level, std::vector<int> *tiles) {
+  if (a.latitude() > b.latitude()) {
+    std::swap(a, b);
+  }
+  const int64_t ax = a.longitude(), ay = a.latitude();
+  const int64_t dx = (int64_t)b.longitude() - ax;
+  const int64_t dy = (int64_t)b.latitude() - ay;
+  const int64_t size = 1LL << (31 - level);
+  int firstRow = grid::row(clampLatitude(ay - bufferY), level);
+  int lastRow = grid::row(clampLatitude(ay + dy + bufferY), level);
+  for (int row = firstRow; row <= lastRow; row++) {
+    grid::Rect band = grid::area(0, row, level);
+    int64_t lo = std::max(ay, band.south - bufferY);
+    int64_t hi = std::min(ay + dy, band.north + bufferY);
+    // The row is half-open, touching its northern border does not count.
+    if (lo > hi || lo == band.north + bufferY) {
+      continue;
+    }
+    int64_t x1 = ax, x2 = ax + dx;
+    if (dy != 0) {
+      x1 = ax + floorDiv((__int128)(lo - ay) * dx, dy);
+      x2 = ax + floorDiv((__int128)(hi - ay) * dx, dy);
+    }
+    addRow(floorDiv(std::min(x1, x2) - bufferX, size),
+           floorDiv(std::max(x1, x2) + bufferX, size), row, level, tiles);
+  }
+}
+
+/*
+ * Sorts tile numbers into ranges, dropping duplicates.
+ */
+std::vector<TileRange> toRanges(std::vector<int> *tiles) {
+  std::sort(tiles->begin(), tiles->end());
+  std::vector<TileRange> ranges;
+  for (size_t i = 0; i < tiles->size(); i++) {
+    if (i == 0 || (*tiles)[i] != (*tiles)[i - 1]) {
+      addRange(&ranges, (*tiles)[i], (*tiles)[i]);
+    }
+  }
+  return ranges;
+}
+} // namespace
+
+std::vector<TileRange> coverRanges(const NdsBbox &bbox, int level) {
+  checkLevel(level);
+  if (bbox.south() > bbox.north()) {
+    return {};
+  }
+  std::vector<Interval> cols;
+  int west = grid::column(bbox.west(), level);
+  int east = grid::column(bbox.east(), level);
+  if (bbox.west() <= bbox.east()) {
+    addInterval(west, east, grid::columnBits(level), &cols);
+  } else {
+    // Crossing the antimeridian.
+    addInterval(west, grid::column(kMaxLongitude, level),
+                grid::columnBits(level), &cols);
+    addInterval(grid::column(kMinLongitude, level), east,
+                grid::columnBits(level), &cols);
+  }
+  normalize(&cols);
+  std::vector<Interval> rows;
+  if (level == 0) {
+    rows.push_back({0, 0});
+  } else {
+    addInterval(grid::row(bbox.south(), level), grid::row(bbox.north(), level),
+                grid::rowBits(level), &rows);
+    normalize(&rows);
+  }
+
+  /*
+   * The column has one bit more than the row: the top bit of the tile number
+   * selects the hemisphere, below that the grid is a quadtree.
+   */
+  RangeCollector collector(cols, rows);
+  const uint32_t size = 1u << level;
+  collector.visit(0, 0, size, 0);
+  collector.visit(size, 0, size, (int64_t)size * size);
+  return std::move(collector.ranges());
+}
+
+std::vector<TileRange> coverRanges(const Wgs84Bbox &bbox, int level) {
+  return coverRanges(toNds(bbox), level);
+}
+
+std::vector<NdsTile> toTiles(const std::vector<TileRange> &ranges, int level) {
+  std::vector<NdsTile> tiles;
+  tiles.reserve(countTiles(ranges));
+  for (const TileRange &range : ranges) {
+    for (int64_t nr = range.first; nr <= range.last; nr++) {
+      tiles.emplace_back(level, (int)nr);
+    }
+  }
+  return tiles;
+}
+
+std::vector<NdsTile> coverTiles(const NdsBbox &bbox, int level) {
+  return toTiles(coverRanges(bbox, level), level);
+}
+
+std::vector<NdsTile> coverTiles(const Wgs84Bbox &bbox, int level) {
+  return toTiles(coverRanges(bbox, level), level);
+}
+
+std::vector<int> coverPackedIds(const NdsBbox &bbox, int level) {
+  std::vector<TileRange> ranges = coverRanges(bbox, level);
+  std::vector<int> packedIds;
+  packedIds.reserve(countTiles(ranges));
+  for (const TileRange &range : ranges) {
+    for (int64_t nr = range.first; nr <= range.last; nr++) {
+      packedIds.push_back((int)((uint32_t)nr + (uint32_t)levelBit(level)));
+    }
+  }
+  return packedIds;
+}
+
+std::vector<int> coverPackedIds(const Wgs84Bbox &bbox, int level) {
+  return coverPackedIds(toNds(bbox), level);
+}
+
+PolygonCover coverPolygon(const std::vector<std::vector<NdsCoordinate>> &rings,
+                          int level) {
+  checkLevel(level);
+  std::vector<Edge> edges;
+  for (const std::vector<NdsCoordinate> &ring : rings) {
+    for (size_t i = 0; i < ring.size(); i++) {
+      const NdsCoordinate &a = ring[i];
+      const NdsCoordinate &b = ring[(i + 1) % ring.size()];
+      if (a == b) {
+        continue;
+      }
+      edges.push_back({a.longitude(), a.latitude(), b.longitude(),
+                       b.latitude()});
+    }
+  }
+  std::vector<uint32_t> edgeIds(edges.size());
+  for (size_t i = 0; i < edges.size(); i++) {
+    edgeIds[i] = (uint32_t)i;
+  }
+  PolygonCoverer coverer(edges, level);
+  coverer.visit(0, 0, edgeIds);
+  coverer.visit(0, 1, edgeIds);
+  return std::move(coverer.cover());
+}
+
+PolygonCover
+coverPolygon(const std::vector<std::vector<Wgs84Coordinate>> &rings,
+             int level) {
+  std::vector<std::vector<NdsCoordinate>> ndsRings;
+  for (const std::vector<Wgs84Coordinate> &ring : rings) {
+    ndsRings.emplace_back();
+    for (const Wgs84Coordinate &c : ring) {
+      ndsRings.back().emplace_back(c.longitude(), c.latitude());
+    }
+  }
+  return coverPolygon(ndsRings, level);
+}
+
+std::vector<TileRange> coverPolyline(const std::vector<NdsCoordinate> &line,
+                                     int level, double corridorMeters) {
+  checkLevel(level);
+  const double buffer = corridorMeters / kMetersPerDegree * kUnitsPerDegree;
+  std::vector<int> tiles;
+  // A single vertex is covered as a zero length segment.
+  size_t segments = line.size() > 1 ? line.size() - 1 : line.size();
+  for (size_t i = 0; i < segments; i++) {
+    const NdsCoordinate &a = line[i];
+    const NdsCoordinate &b = line[std::min(i + 1, line.size() - 1)];
+    // Scale the longitude buffer for the latitude farthest from the equator.
+    double maxLat = std::max(std::abs((double)a.latitude()),
+                             std::abs((double)b.latitude()));
+    double degrees = std::min((maxLat + buffer) / kUnitsPerDegree, 90.0);
+    double cosLat = std::cos(degrees * M_PI / 180.0);
+    double bufferX = cosLat > buffer / kLongitudeRange ? buffer / cosLat
+                                                       : kLongitudeRange;
+    coverSegment(a, b, (int64_t)std::ceil(bufferX), (int64_t)std::ceil(buffer),
+                 level, &tiles);
+  }
+  return toRanges(&tiles);
+}
+
+std::vector<TileRange> coverPolyline(const std::vector<Wgs84Coordinate> &line,
+                                     int level, double corridorMeters) {
+  std::vector<NdsCoordinate> ndsLine;
+  ndsLine.reserve(line.size());
+  for (const Wgs84Coordinate &c : line) {
+    ndsLine.emplace_back(c.longitude(), c.latitude());
+  }
+  return coverPolyline(ndsLine, level, corridorMeters);
+}
+
+std::vector<TileRange> coverRadius(const NdsCoordinate &center,
+                                   double radiusMeters, int level) {
+  checkLevel(level);
+  if (!(radiusMeters >= 0)) {
+    LOG(FATAL) << "Invalid radius: " << radiusMeters;
+  }
+  const double radius = radiusMeters / kMetersPerDegree * kUnitsPerDegree;
+  const double cx = center.longitude(), cy = center.latitude();
+  const double cosLat = std::cos(cy / kUnitsPerDegree * M_PI / 180.0);
+  const int64_t size = 1LL << (31 - level);
+  std::vector<int> tiles;
+  int firstRow =
+      grid::row(clampLatitude((int64_t)std::floor(cy - radius)), level);
+  int lastRow =
+      grid::row(clampLatitude((int64_t)std::floor(cy + radius)), level);
+  for (int row = firstRow; row <= lastRow; row++) {
+    // The widest part of the disc within the row is at its latitude closest
+    // to the center.
+    grid::Rect band = grid::area(0, row, level);
+    double dy = std::max({0.0, band.south - cy, cy - band.north});
+    double halfWidth = std::sqrt(std::max(0.0, radius * radius - dy * dy));
+    if (halfWidth >= cosLat * kLongitudeRange) {
+      addRow(0, kLongitudeRange, row, level, &tiles);
+      continue;
+    }
+    halfWidth /= cosLat;
+    addRow(floorDiv((int64_t)std::floor(cx - halfWidth), size),
+           floorDiv((int64_t)std::floor(cx + halfWidth), size), row, level,
+           &tiles);
+  }
+  return toRanges(&tiles);
+}
+
+std::vector<TileRange> coverRadius(const Wgs84Coordinate &center,
+                                   double radiusMeters, int level) {
+  return coverRadius(NdsCoordinate(center.longitude(), center.latitude()),
+                     radiusMeters, level);
+}
+
+std::vector<TileRange> coverRing(const NdsTile &tile, int k) {
+  if (k < 0) {
+    LOG(FATAL) << "Invalid ring count: " << k;
+  }
+  const int level = tile.level();
+  int col = 0, row = 0;
+  grid::position(tile.tileNumber(), level, &col, &row);
+  std::vector<int> tiles;
+  int firstRow = (int)std::max<int64_t>((int64_t)row - k, grid::minRow(level));
+  int lastRow = (int)std::min<int64_t>((int64_t)row + k, grid::maxRow(level));
+  for (int r = firstRow; r <= lastRow; r++) {
+    addRow((int64_t)col - k, (int64_t)col + k, r, level, &tiles);
+  }
+  return toRanges(&tiles);
+}
+
+} // namespace nds
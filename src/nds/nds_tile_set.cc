@@ -0,0 +1,749 @@
+#include "nds/nds_tile_set.h"
+//
+#include <algorithm>
+#include <glog/logging.h>
+#include <iterator>
+
+namespace nds {
+namespace {
+uint32_t popCount(uint64_t bits) {
+  return (uint32_t)std::bitset<64>(bits).count();
+}
+
+/*
+ * Sets the bits lo..hi (inclusive) of a bitmap.
+ */
+void setBits(std::vector<uint64_t> *words, uint32_t lo, uint32_t hi) {
+  for (uint32_t w = lo >> 6; w <= hi >> 6; w++) {
+    uint32_t first = std::max(lo, w << 6) & 63;
+    uint32_t last = std::min(hi, w << 6 | 63) & 63;
+    uint64_t mask = (~0ULL >> (63 - last)) & (~0ULL << first);
+    (*words)[w] |= mask;
+  }
+}
+
+/*
+ * Clears the bits lo..hi (inclusive) of a bitmap.
+ */
+void clearBits(std::vector<uint64_t> *words, uint32_t lo, uint32_t hi) {
+  for (uint32_t w = lo >> 6; w <= hi >> 6; w++) {
+    uint32_t first = std::max(lo, w << 6) & 63;
+    uint32_t last = std::min(hi, w << 6 | 63) & 63;
+    (*words)[w] &= ~((~0ULL >> (63 - last)) & (~0ULL << first));
+  }
+}
+
+/*
+ * The ranges of the children of the tiles within the ranges.
+ */
+std::vector<TileRange> childRanges(const std::vector<TileRange> &ranges) {
+  std::vector<TileRange> children;
+  children.reserve(ranges.size());
+  for (const TileRange &r : ranges) {
+    children.push_back({r.first * 4, r.last * 4 + 3});
+  }
+  return children;
+}
+
+/*
+ * Merges two lists of sorted, disjoint ranges into one, joining adjacent
+ * ranges.
+ */
+std::vector<TileRange> mergeRanges(const std::vector<TileRange> &a,
+                                   const std::vector<TileRange> &b) {
+  std::vector<TileRange> merged;
+  merged.reserve(a.size() + b.size());
+  std::merge(a.begin(), a.end(), b.begin(), b.end(),
+             std::back_inserter(merged),
+             [](const TileRange &x, const TileRange &y) {
+               return x.first < y.first;
+             });
+  std::vector<TileRange> joined;
+  for (const TileRange &r : merged) {
+    if (!joined.empty() && (int64_t)joined.back().last + 1 >= r.first) {
+      joined.back().last = std::max(joined.back().last, r.last);
+    } else {
+      joined.push_back(r);
+    }
+  }
+  return joined;
+}
+
+void putU16(std::vector<uint8_t> *out, uint16_t v) {
+  out->push_back((uint8_t)v);
+  out->push_back((uint8_t)(v >> 8));
+}
+
+void putU32(std::vector<uint8_t> *out, uint32_t v) {
+  putU16(out, (uint16_t)v);
+  putU16(out, (uint16_t)(v >> 16));
+}
+
+void putU64(std::vector<uint8_t> *out, uint64_t v) {
+  putU32(out, (uint32_t)v);
+  putU32(out, (uint32_t)(v >> 32));
+}
+
+/*
+ * Little endian reader with bounds checking.
+ */
+class Reader {
+public:
+  Reader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  bool u16(uint16_t *v) {
+    if (size_ - pos_ < 2) {
+      return false;
+    }
+    *v = (uint16_t)(data_[pos_] | data_[pos_ + 1] << 8);
+    pos_ += 2;
+    return true;
+  }
+  bool u32(uint32_t *v) {
+    uint16_t lo = 0, hi = 0;
+    if (!u16(&lo) || !u16(&hi)) {
+      return false;
+    }
+    *v = lo | (uint32_t)hi << 16;
+    return true;
+  }
+  bool u64(uint64_t *v) {
+    uint32_t lo = 0, hi = 0;
+    if (!u32(&lo) || !u32(&hi)) {
+      return false;
+    }
+    *v = lo | (uint64_t)hi << 32;
+    return true;
+  }
+  bool atEnd() const { return pos_ == size_; }
+
+private:
+  const uint8_t *data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+constexpr uint8_t kMagic[4] = {'N', 'D', 'T', 'S'};
+} // namespace
+
+bool TileBitmap::Container::contains(uint16_t low) const {
+  if (words.empty()) {
+    return std::binary_search(values.begin(), values.end(), low);
+  }
+  return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+TileBitmap::Container *TileBitmap::find(uint16_t key) {
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container &c, uint16_t k) { return c.key < k; });
+  return it != containers_.end() && it->key == key ? &*it : nullptr;
+}
+
+const TileBitmap::Container *TileBitmap::find(uint16_t key) const {
+  return const_cast<TileBitmap *>(this)->find(key);
+}
+
+TileBitmap::Container &TileBitmap::findOrInsert(uint16_t key) {
+  auto it = std::lower_bound(
+      containers_.begin(), containers_.end(), key,
+      [](const Container &c, uint16_t k) { return c.key < k; });
+  if (it == containers_.end() || it->key != key) {
+    it = containers_.insert(it, Container());
+    it->key = key;
+  }
+  return *it;
+}
+
+void TileBitmap::toBitmap(Container *c) {
+  if (!c->words.empty()) {
+    return;
+  }
+  c->words.assign(kWords, 0);
+  for (uint16_t low : c->values) {
+    c->words[low >> 6] |= 1ULL << (low & 63);
+  }
+  c->values.clear();
+  c->values.shrink_to_fit();
+}
+
+/*
+ * Recounts a bitmap and picks the smaller representation.
+ */
+void TileBitmap::normalize(Container *c) {
+  if (c->words.empty()) {
+    c->cardinality = (uint32_t)c->values.size();
+    if (c->cardinality > kMaxArraySize) {
+      toBitmap(c);
+    }
+    return;
+  }
+  c->cardinality = 0;
+  for (uint64_t w : c->words) {
+    c->cardinality += popCount(w);
+  }
+  if (c->cardinality <= kMaxArraySize) {
+    c->values.clear();
+    c->values.reserve(c->cardinality);
+    for (uint32_t w = 0; w < kWords; w++) {
+      for (uint64_t bits = c->words[w]; bits != 0; bits &= bits - 1) {
+        c->values.push_back((uint16_t)(w << 6 | countTrailingZeros(bits)));
+      }
+    }
+    c->words.clear();
+    c->words.shrink_to_fit();
+  }
+}
+
+TileBitmap::Container TileBitmap::unite(const Container &a,
+                                        const Container &b) {
+  Container c;
+  c.key = a.key;
+  if (a.words.empty() && b.words.empty() &&
+      a.values.size() + b.values.size() <= kMaxArraySize) {
+    std::set_union(a.values.begin(), a.values.end(), b.values.begin(),
+                   b.values.end(), std::back_inserter(c.values));
+  } else {
+    c = a.words.empty() ? b : a;
+    const Container &other = a.words.empty() ? a : b;
+    toBitmap(&c);
+    if (other.words.empty()) {
+      for (uint16_t low : other.values) {
+        c.words[low >> 6] |= 1ULL << (low & 63);
+      }
+    } else {
+      for (uint32_t w = 0; w < kWords; w++) {
+        c.words[w] |= other.words[w];
+      }
+    }
+  }
+  normalize(&c);
+  return c;
+}
+
+TileBitmap::Container TileBitmap::intersect(const Container &a,
+                                            const Container &b) {
+  Container c;
+  c.key = a.key;
+  if (a.words.empty() && b.words.empty()) {
+    std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(),
+                          b.values.end(), std::back_inserter(c.values));
+  } else if (a.words.empty() || b.words.empty()) {
+    const Container &array = a.words.empty() ? a : b;
+    const Container &bitmap = a.words.empty() ? b : a;
+    for (uint16_t low : array.values) {
+      if (bitmap.contains(low)) {
+        c.values.push_back(low);
+      }
+    }
+  } else {
+    c.words.resize(kWords);
+    for (uint32_t w = 0; w < kWords; w++) {
+      c.words[w] = a.words[w] & b.words[w];
+    }
+  }
+  normalize(&c);
+  return c;
+}
+
+TileBitmap::Container TileBitmap::subtract(const Container &a,
+                                           const Container &b) {
+  Container c;
+  c.key = a.key;
+  if (a.words.empty()) {
+    for (uint16_t low : a.values) {
+      if (!b.contains(low)) {
+        c.values.push_back(low);
+      }
+    }
+  } else {
+    c.words = a.words;
+    if (b.words.empty()) {
+      for (uint16_t low : b.values) {
+        c.words[low >> 6] &= ~(1ULL << (low & 63));
+      }
+    } else {
+      for (uint32_t w = 0; w < kWords; w++) {
+        c.words[w] &= ~b.words[w];
+      }
+    }
+  }
+  normalize(&c);
+  return c;
+}
+
+void TileBitmap::add(int nr) {
+  if (nr < 0) {
+    LOG(FATAL) << "Invalid tile number " << nr;
+  }
+  Container &c = findOrInsert((uint16_t)(nr >> 16));
+  const uint16_t low = (uint16_t)nr;
+  if (c.words.empty()) {
+    auto it = std::lower_bound(c.values.begin(), c.values.end(), low);
+    if (it != c.values.end() && *it == low) {
+      return;
+    }
+    c.values.insert(it, low);
+    if (++c.cardinality > kMaxArraySize) {
+      toBitmap(&c);
+    }
+  } else if (!c.contains(low)) {
+    c.words[low >> 6] |= 1ULL << (low & 63);
+    c.cardinality++;
+  }
+}
+
+void TileBitmap::add(const TileRange &range) {
+  if (range.first < 0 || range.first > range.last) {
+    LOG(FATAL) << "Invalid tile number range " << range.first << ".."
+               << range.last;
+  }
+  for (int64_t key = range.first >> 16; key <= range.last >> 16; key++) {
+    const uint32_t lo = (uint32_t)std::max<int64_t>(range.first, key << 16);
+    const uint32_t hi =
+        (uint32_t)std::min<int64_t>(range.last, key << 16 | 0xFFFF);
+    Container &c = findOrInsert((uint16_t)key);
+    if (c.words.empty() && c.cardinality + (hi - lo + 1) <= kMaxArraySize) {
+      std::vector<uint16_t> added;
+      for (uint32_t v = lo; v <= hi; v++) {
+        added.push_back((uint16_t)v);
+      }
+      std::vector<uint16_t> merged;
+      std::set_union(c.values.begin(), c.values.end(), added.begin(),
+                     added.end(), std::back_inserter(merged));
+      c.values.swap(merged);
+    } else {
+      toBitmap(&c);
+      setBits(&c.words, lo & 0xFFFF, hi & 0xFFFF);
+    }
+    normalize(&c);
+  }
+}
+
+void TileBitmap::add(const std::vector<TileRange> &ranges) {
+  // Ascending ranges only append to the last container of the new bitmap.
+  TileBitmap added;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    const TileRange &range = ranges[i];
+    if (range.first < 0 || range.first > range.last ||
+        (i > 0 && ranges[i - 1].last >= range.first)) {
+      LOG(FATAL) << "Invalid or unsorted tile number range " << range.first
+                 << ".." << range.last;
+    }
+    for (int64_t key = range.first >> 16; key <= range.last >> 16; key++) {
+      const uint32_t lo = (uint32_t)std::max<int64_t>(range.first, key << 16);
+      const uint32_t hi =
+          (uint32_t)std::min<int64_t>(range.last, key << 16 | 0xFFFF);
+      if (added.containers_.empty() || added.containers_.back().key != key) {
+        added.containers_.emplace_back();
+        added.containers_.back().key = (uint16_t)key;
+      }
+      Container &c = added.containers_.back();
+      if (c.words.empty() && c.values.size() + (hi - lo + 1) <= kMaxArraySize) {
+        for (uint32_t v = lo; v <= hi; v++) {
+          c.values.push_back((uint16_t)v);
+        }
+      } else {
+        toBitmap(&c);
+        setBits(&c.words, lo & 0xFFFF, hi & 0xFFFF);
+      }
+    }
+  }
+  for (Container &c : added.containers_) {
+    normalize(&c);
+  }
+  *this |= added;
+}
+
+bool TileBitmap::remove(int nr) {
+  Container *c = nr < 0 ? nullptr : find((uint16_t)(nr >> 16));
+  const uint16_t low = (uint16_t)nr;
+  if (c == nullptr || !c->contains(low)) {
+    return false;
+  }
+  if (c->words.empty()) {
+    c->values.erase(std::lower_bound(c->values.begin(), c->values.end(), low));
+  } else {
+    c->words[low >> 6] &= ~(1ULL << (low & 63));
+  }
+  if (--c->cardinality == kMaxArraySize) {
+    normalize(c);
+  }
+  if (c->cardinality == 0) {
+    containers_.erase(containers_.begin() + (c - containers_.data()));
+  }
+  return true;
+}
+
+void TileBitmap::remove(const TileRange &range) {
+  if (range.first > range.last || range.last < 0) {
+    return;
+  }
+  remove(std::vector<TileRange>{range});
+}
+
+void TileBitmap::remove(const std::vector<TileRange> &ranges) {
+  auto r = ranges.begin();
+  bool emptied = false;
+  for (Container &c : containers_) {
+    const int64_t base = (int64_t)c.key << 16;
+    const int64_t top = base | 0xFFFF;
+    while (r != ranges.end() && r->last < base) {
+      ++r;
+    }
+    if (r == ranges.end()) {
+      break;
+    }
+    if (r->first > top) {
+      continue;
+    }
+    if (c.words.empty()) {
+      // Merge the values with the ranges, keeping those outside.
+      auto q = r;
+      size_t kept = 0;
+      for (uint16_t low : c.values) {
+        while (q != ranges.end() && q->last < (base | low)) {
+          ++q;
+        }
+        if (q == ranges.end() || (base | low) < q->first) {
+          c.values[kept++] = low;
+        }
+      }
+      c.values.resize(kept);
+    } else {
+      for (auto q = r; q != ranges.end() && q->first <= top; ++q) {
+        clearBits(&c.words,
+                  (uint32_t)(std::max<int64_t>(q->first, base) - base),
+                  (uint32_t)(std::min<int64_t>(q->last, top) - base));
+      }
+    }
+    normalize(&c);
+    emptied |= c.cardinality == 0;
+  }
+  if (emptied) {
+    containers_.erase(std::remove_if(containers_.begin(), containers_.end(),
+                                     [](const Container &c) {
+                                       return c.cardinality == 0;
+                                     }),
+                      containers_.end());
+  }
+}
+
+bool TileBitmap::contains(int nr) const {
+  const Container *c = nr < 0 ? nullptr : find((uint16_t)(nr >> 16));
+  return c != nullptr && c->contains((uint16_t)nr);
+}
+
+uint64_t TileBitmap::cardinality() const {
+  uint64_t n = 0;
+  for (const Container &c : containers_) {
+    n += c.cardinality;
+  }
+  return n;
+}
+
+size_t TileBitmap::memoryUsage() const {
+  size_t bytes = containers_.capacity() * sizeof(Container);
+  for (const Container &c : containers_) {
+    bytes += c.values.capacity() * sizeof(uint16_t) +
+             c.words.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+TileBitmap &TileBitmap::operator|=(const TileBitmap &other) {
+  std::vector<Container> result;
+  auto a = containers_.begin();
+  auto b = other.containers_.begin();
+  while (a != containers_.end() || b != other.containers_.end()) {
+    if (b == other.containers_.end() ||
+        (a != containers_.end() && a->key < b->key)) {
+      result.push_back(std::move(*a++));
+    } else if (a == containers_.end() || b->key < a->key) {
+      result.push_back(*b++);
+    } else {
+      result.push_back(unite(*a++, *b++));
+    }
+  }
+  containers_.swap(result);
+  return *this;
+}
+
+TileBitmap &TileBitmap::operator&=(const TileBitmap &other) {
+  std::vector<Container> result;
+  for (Container &c : containers_) {
+    const Container *o = other.find(c.key);
+    if (o != nullptr) {
+      Container i = intersect(c, *o);
+      if (i.cardinality > 0) {
+        result.push_back(std::move(i));
+      }
+    }
+  }
+  containers_.swap(result);
+  return *this;
+}
+
+TileBitmap &TileBitmap::operator-=(const TileBitmap &other) {
+  std::vector<Container> result;
+  for (Container &c : containers_) {
+    const Container *o = other.find(c.key);
+    if (o == nullptr) {
+      result.push_back(std::move(c));
+      continue;
+    }
+    Container d = subtract(c, *o);
+    if (d.cardinality > 0) {
+      result.push_back(std::move(d));
+    }
+  }
+  containers_.swap(result);
+  return *this;
+}
+
+bool TileBitmap::operator==(const TileBitmap &other) const {
+  if (containers_.size() != other.containers_.size()) {
+    return false;
+  }
+  // Both representations are normalized, so equal sets are stored equally.
+  for (size_t i = 0; i < containers_.size(); i++) {
+    const Container &a = containers_[i], &b = other.containers_[i];
+    if (a.key != b.key || a.values != b.values || a.words != b.words) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<TileRange> TileBitmap::ranges() const {
+  std::vector<TileRange> result;
+  forEach([&](int nr) {
+    if (!result.empty() && result.back().last + 1 == nr) {
+      result.back().last = nr;
+    } else {
+      result.push_back({nr, nr});
+    }
+  });
+  return result;
+}
+
+void TileSet::insert(int level, const TileRange &range) {
+  if (level < 0 || level > kMaxLevel ||
+      range.last > (int)((1LL << (2 * level + 1)) - 1)) {
+    LOG(FATAL) << "Invalid tile number range " << range.first << ".."
+               << range.last << " for level " << level;
+  }
+  levels_[level].add(range);
+}
+
+void TileSet::erase(int level, const TileRange &range) {
+  if (level < 0 || level > kMaxLevel) {
+    LOG(FATAL) << "The Tile level " << level << " exceeds the range [0, 15].";
+  }
+  levels_[level].remove(range);
+}
+
+void TileSet::normalize() {
+  // Top down, drop the tiles within the area of the lower levels.
+  std::vector<TileRange> covered;
+  for (int level = 1; level <= kMaxLevel; level++) {
+    covered = mergeRanges(childRanges(covered),
+                          childRanges(levels_[level - 1].ranges()));
+    levels_[level].remove(covered);
+  }
+  // Bottom up, replace aligned groups of four children by their parents.
+  for (int level = kMaxLevel; level > 0; level--) {
+    std::vector<TileRange> children, parents;
+    for (const TileRange &range : levels_[level].ranges()) {
+      int first = (int)(((int64_t)range.first + 3) / 4);
+      int last = (int)(((int64_t)range.last + 1) / 4 - 1);
+      if (first <= last) {
+        children.push_back({first * 4, last * 4 + 3});
+        parents.push_back({first, last});
+      }
+    }
+    levels_[level].remove(children);
+    levels_[level - 1].add(parents);
+  }
+}
+
+void TileSet::expand(int level) {
+  if (level < 0 || level > kMaxLevel) {
+    LOG(FATAL) << "The Tile level " << level << " exceeds the range [0, 15].";
+  }
+  // The mapped ranges of each level are ascending, but may overlap.
+  std::vector<TileRange> ranges;
+  for (int l = 0; l <= kMaxLevel; l++) {
+    std::vector<TileRange> mapped;
+    for (const TileRange &r : levels_[l].ranges()) {
+      if (l <= level) {
+        int shift = 2 * (level - l);
+        mapped.push_back({r.first << shift,
+                          (int)((((int64_t)r.last + 1) << shift) - 1)});
+      } else {
+        int shift = 2 * (l - level);
+        mapped.push_back({r.first >> shift, r.last >> shift});
+      }
+    }
+    ranges = mergeRanges(ranges, mapped);
+    levels_[l].clear();
+  }
+  TileBitmap expanded;
+  expanded.add(ranges);
+  levels_[level] = std::move(expanded);
+}
+
+uint64_t TileSet::size() const {
+  uint64_t n = 0;
+  for (const TileBitmap &level : levels_) {
+    n += level.cardinality();
+  }
+  return n;
+}
+
+bool TileSet::empty() const {
+  for (const TileBitmap &level : levels_) {
+    if (!level.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t TileSet::memoryUsage() const {
+  size_t bytes = 0;
+  for (const TileBitmap &level : levels_) {
+    bytes += level.memoryUsage();
+  }
+  return bytes;
+}
+
+TileSet &TileSet::operator|=(const TileSet &other) {
+  for (int level = 0; level <= kMaxLevel; level++) {
+    levels_[level] |= other.levels_[level];
+  }
+  return *this;
+}
+
+TileSet &TileSet::operator&=(const TileSet &other) {
+  for (int level = 0; level <= kMaxLevel; level++) {
+    levels_[level] &= other.levels_[level];
+  }
+  return *this;
+}
+
+TileSet &TileSet::operator-=(const TileSet &other) {
+  for (int level = 0; level <= kMaxLevel; level++) {
+    levels_[level] -= other.levels_[level];
+  }
+  return *this;
+}
+
+bool TileSet::operator==(const TileSet &other) const {
+  for (int level = 0; level <= kMaxLevel; level++) {
+    if (!(levels_[level] == other.levels_[level])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TileSet::serialize(std::vector<uint8_t> *out) const {
+  out->insert(out->end(), std::begin(kMagic), std::end(kMagic));
+  uint16_t levelMask = 0;
+  for (int level = 0; level <= kMaxLevel; level++) {
+    if (!levels_[level].empty()) {
+      levelMask |= (uint16_t)(1u << level);
+    }
+  }
+  putU16(out, levelMask);
+  for (const TileBitmap &level : levels_) {
+    if (level.empty()) {
+      continue;
+    }
+    putU32(out, (uint32_t)level.containers_.size());
+    for (const TileBitmap::Container &c : level.containers_) {
+      putU16(out, c.key);
+      putU16(out, (uint16_t)(c.cardinality - 1));
+      for (uint16_t low : c.values) {
+        putU16(out, low);
+      }
+      for (uint64_t w : c.words) {
+        putU64(out, w);
+      }
+    }
+  }
+}
+
+Result<TileSet> TileSet::deserialize(const uint8_t *data, size_t size) {
+  if (size < sizeof(kMagic) ||
+      !std::equal(std::begin(kMagic), std::end(kMagic), data)) {
+    return Status::kInvalidData;
+  }
+  Reader in(data + sizeof(kMagic), size - sizeof(kMagic));
+  TileSet set;
+  uint16_t levelMask = 0;
+  if (!in.u16(&levelMask)) {
+    return Status::kInvalidData;
+  }
+  for (int level = 0; level <= kMaxLevel; level++) {
+    if ((levelMask >> level & 1) == 0) {
+      continue;
+    }
+    const uint64_t maxNr = (1ULL << (2 * level + 1)) - 1;
+    uint32_t count = 0;
+    if (!in.u32(&count) || count == 0 || count > (maxNr >> 16) + 1) {
+      return Status::kInvalidData;
+    }
+    std::vector<TileBitmap::Container> &containers =
+        set.levels_[level].containers_;
+    containers.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+      TileBitmap::Container &c = containers[i];
+      uint16_t cardinality = 0;
+      if (!in.u16(&c.key) || !in.u16(&cardinality) ||
+          (i > 0 && c.key <= containers[i - 1].key) ||
+          c.key > (maxNr >> 16)) {
+        return Status::kInvalidData;
+      }
+      c.cardinality = (uint32_t)cardinality + 1;
+      if (c.cardinality <= TileBitmap::kMaxArraySize) {
+        c.values.resize(c.cardinality);
+        for (uint32_t v = 0; v < c.cardinality; v++) {
+          if (!in.u16(&c.values[v]) ||
+              (v > 0 && c.values[v] <= c.values[v - 1])) {
+            return Status::kInvalidData;
+          }
+        }
+      } else {
+        c.words.resize(TileBitmap::kWords);
+        uint32_t bits = 0;
+        for (uint64_t &w : c.words) {
+          if (!in.u64(&w)) {
+            return Status::kInvalidData;
+          }
+          bits += popCount(w);
+        }
+        if (bits != c.cardinality) {
+          return Status::kInvalidData;
+        }
+      }
+      // The numbers must be admissible for the level.
+      uint32_t largest = c.words.empty() ? c.values.back() : 0xFFFF;
+      if (!c.words.empty()) {
+        while ((c.words[largest >> 6] >> (largest & 63) & 1) == 0) {
+          largest--;
+        }
+      }
+      if (((uint64_t)c.key << 16 | largest) > maxNr) {
+        return Status::kInvalidData;
+      }
+    }
+  }
+  if (!in.atEnd()) {
+    return Status::kInvalidData;
+  }
+  return set;
+}
+
+} // namespace nds
@@ -0,0 +1,91 @@
+#pragma once
+/**
+ * The tiles of a level form a grid of 2^(level+1) columns and 2^level rows.
+ * Column and row are the leading bits of the NDS longitude / 31-bit latitude,
+ * i.e. signed values, and the tile number interleaves their two's complement
+ * bits like the Morton code does for coordinates.
+ */
+#include "nds/nds_morton.h"
+#include "nds/nds_tile.h"
+
+namespace nds {
+namespace grid {
+
+constexpr int columnBits(int level) { return level + 1; }
+constexpr int rowBits(int level) { return level; }
+
+/**
+ * The signed column of the tiles containing the longitude.
+ */
+constexpr int column(int lon, int level) { return lon >> (31 - level); }
+
+/**
+ * The signed row of the tiles containing the latitude. Level 0 has a single
+ * row.
+ */
+constexpr int row(int lat, int level) {
+  return level == 0 ? 0 : lat >> (31 - level);
+}
+
+/**
+ * The smallest and largest signed column / row.
+ */
+constexpr int minColumn(int level) { return -(1 << level); }
+constexpr int maxColumn(int level) { return (1 << level) - 1; }
+constexpr int minRow(int level) { return level == 0 ? 0 : -(1 << (level - 1)); }
+constexpr int maxRow(int level) {
+  return level == 0 ? 0 : (1 << (level - 1)) - 1;
+}
+
+/**
+ * The tile number of the tile in the given signed column and row.
+ */
+constexpr int tileNumber(int col, int row, int level) {
+  uint32_t x = (uint32_t)col & ((1u << columnBits(level)) - 1);
+  uint32_t y = (uint32_t)row & ((1u << rowBits(level)) - 1);
+  return (int)(morton::spreadBits(x) | morton::spreadBits(y) << 1);
+}
+
+/**
+ * Splits a tile number into its signed column and row.
+ */
+constexpr void position(int tileNumber, int level, int *col, int *row) {
+  uint32_t x = morton::compactBits((uint32_t)tileNumber);
+  uint32_t y = morton::compactBits((uint32_t)tileNumber >> 1);
+  // Sign extend from the column / row bit count.
+  int colShift = 32 - columnBits(level);
+  *col = (int)(x << colShift) >> colShift;
+  int rowShift = 32 - rowBits(level);
+  *row = level == 0 ? 0 : (int)(y << rowShift) >> rowShift;
+}
+
+/**
+ * The area of a tile as closed rectangle in NDS coordinates. East and north
+ * are the first coordinates of the neighboring tiles, so adjacent tiles
+ * share their edges.
+ */
+struct Rect {
+  int64_t west;
+  int64_t south;
+  int64_t east;
+  int64_t north;
+};
+
+constexpr Rect area(int col, int row, int level) {
+  int64_t size = 1LL << (31 - level);
+  int64_t west = (int64_t)col * size;
+  if (level == 0) {
+    return {west, kMinLatitude, west + size, (int64_t)kMaxLatitude + 1};
+  }
+  int64_t south = (int64_t)row * size;
+  return {west, south, west + size, south + size};
+}
+
+constexpr Rect area(int tileNumber, int level) {
+  int col = 0, row = 0;
+  position(tileNumber, level, &col, &row);
+  return area(col, row, level);
+}
+
+} // namespace grid
+} // namespace nds
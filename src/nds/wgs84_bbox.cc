@@ -0,0 +1,13 @@
+#include "nds/wgs84_bbox.h"
+//
+#include "nds/nds_geojson.h"
+
+namespace nds {
+
+std::string Wgs84Bbox::toGeoJSON() const {
+  std::string text;
+  geojson::writePolygon(*this, &text);
+  return text;
+}
+
+} // namespace nds
@@ -1,7 +1,8 @@
 #include "nds/wgs84_coordinate.h"
 //
-#include "configor/json.hpp"
 #include <glog/logging.h>
+//
+#include "nds/nds_geojson.h"
 
 namespace nds {
 Wgs84Coordinate::Wgs84Coordinate(double longitude, double latitude) {
@@ -17,13 +18,25 @@ Wgs84Coordinate::Wgs84Coordinate(double longitude, double latitude) {
   longitude_ = longitude;
 }
 
-std::string Wgs84Coordinate::toGeoJSON() {
-  configor::json geojson;
-  geojson["type"] = "Feature";
-  geojson["properties"] = {};
-  geojson["geometry"]["type"] = "Point";
-  geojson["geometry"]["coordinates"] = {{longitude_, latitude_}};
-  return geojson.dump();
+Result<Wgs84Coordinate> Wgs84Coordinate::create(double longitude,
+                                                double latitude) {
+  // Written as negated ranges, so NaN is rejected as well.
+  if (!(longitude >= -180 && longitude <= 180)) {
+    return Status::kInvalidLongitude;
+  }
+  if (!(latitude >= -90 && latitude <= 90)) {
+    return Status::kInvalidLatitude;
+  }
+  Wgs84Coordinate coord;
+  coord.longitude_ = longitude;
+  coord.latitude_ = latitude;
+  return coord;
+}
+
+std::string Wgs84Coordinate::toGeoJSON() const {
+  std::string text;
+  geojson::writePoint(*this, &text);
+  return text;
 }
 
 } // namespace nds
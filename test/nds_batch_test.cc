@@ -0,0 +1,262 @@
+#include "nds/nds_batch.h"
+//
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <vector>
+//
+#include "nds/nds_coordinate.h"
+#include "nds/nds_tile.h"
+
+namespace nds {
+namespace {
+const SimdLevel kAllLevels[] = {SimdLevel::kScalar, SimdLevel::kSse2,
+                                SimdLevel::kAvx2, SimdLevel::kAvx512};
+
+struct Wgs84Points {
+  std::vector<double> lon;
+  std::vector<double> lat;
+};
+
+Wgs84Points randomPoints(size_t count, unsigned seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> lonDist(-180.0, 180.0);
+  std::uniform_real_distribution<double> latDist(-90.0, 90.0);
+  Wgs84Points points;
+  // Corner cases first, including the exact range limits.
+  const double lons[] = {-180.0, 180.0, 0.0, -0.0, 2.2945, -74.044444};
+  const double lats[] = {-90.0, 90.0, 0.0, -0.0, 48.858222, 40.689167};
+  for (size_t i = 0; i < sizeof(lons) / sizeof(lons[0]); i++) {
+    points.lon.push_back(lons[i]);
+    points.lat.push_back(lats[i]);
+  }
+  while (points.lon.size() < count) {
+    points.lon.push_back(lonDist(rng));
+    points.lat.push_back(latDist(rng));
+  }
+  return points;
+}
+} // namespace
+
+TEST(NDSTEST, testBatchConversionMatchesCoordinate) {
+  LOG(INFO) << "Max SIMD level: " << (int)maxSimdLevel();
+  // Odd count to exercise the scalar tails of all kernels.
+  Wgs84Points points = randomPoints(5003, 1);
+  size_t n = points.lon.size();
+  for (SimdLevel level : kAllLevels) {
+    std::vector<int32_t> lon(n), lat(n);
+    std::vector<int64_t> morton(n);
+    convertWgs84ToNds(points.lon.data(), points.lat.data(), n, lon.data(),
+                      lat.data(), morton.data(), level);
+    for (size_t i = 0; i < n; i++) {
+      NdsCoordinate expected(points.lon[i], points.lat[i]);
+      ASSERT_EQ(expected.longitude(), lon[i])
+          << "level " << (int)level << " lon " << points.lon[i];
+      ASSERT_EQ(expected.latitude(), lat[i])
+          << "level " << (int)level << " lat " << points.lat[i];
+      ASSERT_EQ(expected.getMortonCode(), morton[i]);
+    }
+  }
+}
+
+TEST(NDSTEST, testBatchConversionWithoutMortonCodes) {
+  Wgs84Points points = randomPoints(17, 2);
+  std::vector<int32_t> lon(17), lat(17);
+  convertWgs84ToNds(points.lon.data(), points.lat.data(), 17, lon.data(),
+                    lat.data());
+  EXPECT_EQ(kMinLongitude, lon[0]);
+  EXPECT_EQ(kMinLatitude, lat[0]);
+  EXPECT_EQ(kMaxLongitude, lon[1]);
+  EXPECT_EQ(kMaxLatitude, lat[1]);
+  EXPECT_EQ(27374451, lon[4]);
+  EXPECT_EQ(582901293, lat[4]);
+
+  // Empty input is a no-op.
+  convertWgs84ToNds(nullptr, nullptr, 0, nullptr, nullptr);
+}
+
+TEST(NDSTEST, testBatchConversionOutOfRangeIsFatal) {
+  for (SimdLevel level : kAllLevels) {
+    std::vector<double> lon(9, 10.0), lat(9, 10.0);
+    std::vector<int32_t> ndsLon(9), ndsLat(9);
+    lat[5] = 90.5;
+    EXPECT_DEATH(convertWgs84ToNds(lon.data(), lat.data(), 9, ndsLon.data(),
+                                   ndsLat.data(), nullptr, level),
+                 "latitude value");
+    // NaN and values beyond the int32 range, in the vectors and the tails.
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (size_t i : {2, 8}) {
+      for (double invalid : {nan, 1e300, -1e300}) {
+        lon.assign(9, 10.0);
+        lat.assign(9, 10.0);
+        lon[i] = invalid;
+        EXPECT_DEATH(convertWgs84ToNds(lon.data(), lat.data(), 9,
+                                       ndsLon.data(), ndsLat.data(), nullptr,
+                                       level),
+                     "longitude value");
+        lon[i] = 10.0;
+        lat[i] = invalid;
+        EXPECT_DEATH(convertWgs84ToNds(lon.data(), lat.data(), 9,
+                                       ndsLon.data(), ndsLat.data(), nullptr,
+                                       level),
+                     "latitude value");
+      }
+    }
+  }
+}
+
+TEST(NDSTEST, testBatchMortonEncodingMatchesCoordinate) {
+  std::mt19937_64 rng(3);
+  std::uniform_int_distribution<int32_t> lonDist(kMinLongitude, kMaxLongitude);
+  std::uniform_int_distribution<int32_t> latDist(kMinLatitude, kMaxLatitude);
+  std::vector<int32_t> lon = {0, -1, kMaxLongitude, kMinLongitude, 1};
+  std::vector<int32_t> lat = {0, -1, kMaxLatitude, kMinLatitude, -1};
+  while (lon.size() < 1029) {
+    lon.push_back(lonDist(rng));
+    lat.push_back(latDist(rng));
+  }
+  size_t n = lon.size();
+  for (SimdLevel level : kAllLevels) {
+    std::vector<int64_t> codes(n);
+    encodeMortonCodes(lon.data(), lat.data(), n, codes.data(), level);
+    std::vector<int32_t> decodedLon(n), decodedLat(n);
+    decodeMortonCodes(codes.data(), n, decodedLon.data(), decodedLat.data(),
+                      level);
+    for (size_t i = 0; i < n; i++) {
+      NdsCoordinate expected(lon[i], lat[i]);
+      ASSERT_EQ(expected.getMortonCode(), codes[i])
+          << "level " << (int)level << " lon " << lon[i] << " lat " << lat[i];
+      NdsCoordinate decoded(codes[i]);
+      ASSERT_EQ(decoded.longitude(), decodedLon[i]) << "level " << (int)level;
+      ASSERT_EQ(decoded.latitude(), decodedLat[i]) << "level " << (int)level;
+      ASSERT_EQ(lon[i], decodedLon[i]);
+      ASSERT_EQ(lat[i], decodedLat[i]);
+    }
+  }
+}
+
+TEST(NDSTEST, testBatchMortonDecodingOfArbitraryCodes) {
+  std::mt19937_64 rng(4);
+  std::vector<int64_t> codes = {0L, -1L, std::numeric_limits<int64_t>::max(),
+                                std::numeric_limits<int64_t>::min()};
+  while (codes.size() < 515) {
+    codes.push_back((int64_t)rng());
+  }
+  size_t n = codes.size();
+  for (SimdLevel level : kAllLevels) {
+    std::vector<int32_t> lon(n), lat(n);
+    decodeMortonCodes(codes.data(), n, lon.data(), lat.data(), level);
+    for (size_t i = 0; i < n; i++) {
+      NdsCoordinate expected(codes[i]);
+      ASSERT_EQ(expected.longitude(), lon[i]) << "code " << codes[i];
+      ASSERT_EQ(expected.latitude(), lat[i]) << "code " << codes[i];
+    }
+  }
+}
+
+TEST(NDSTEST, testBatchPackedTileIdsMatchTile) {
+  Wgs84Points points = randomPoints(1500, 5);
+  size_t n = points.lon.size();
+  std::vector<int> tileLevels;
+  for (int l = 0; l <= kMaxLevel; l++) {
+    tileLevels.push_back(l);
+  }
+  for (SimdLevel level : kAllLevels) {
+    std::vector<int32_t> fromWgs84(n * tileLevels.size());
+    computePackedTileIds(points.lon.data(), points.lat.data(), n,
+                         tileLevels.data(), tileLevels.size(),
+                         fromWgs84.data(), level);
+    std::vector<int32_t> ndsLon(n), ndsLat(n);
+    convertWgs84ToNds(points.lon.data(), points.lat.data(), n, ndsLon.data(),
+                      ndsLat.data(), nullptr, level);
+    std::vector<int32_t> fromNds(n * tileLevels.size());
+    computePackedTileIds(ndsLon.data(), ndsLat.data(), n, tileLevels.data(),
+                         tileLevels.size(), fromNds.data(), level);
+    for (size_t j = 0; j < tileLevels.size(); j++) {
+      for (size_t i = 0; i < n; i++) {
+        NdsTile expected(tileLevels[j],
+                         Wgs84Coordinate(points.lon[i], points.lat[i]));
+        ASSERT_EQ(expected.packedId(), fromWgs84[j * n + i])
+            << "level " << (int)level << " tile level " << tileLevels[j];
+        ASSERT_EQ(expected.packedId(), fromNds[j * n + i])
+            << "level " << (int)level << " tile level " << tileLevels[j];
+      }
+    }
+  }
+}
+
+TEST(NDSTEST, testBatchPackedTileIdsSingleLevel) {
+  // Barcelona area, see nds_tile_test.
+  const int32_t lon[] = {24772607};
+  const int32_t lat[] = {493486079};
+  const int tileLevels[] = {11, 12, 13, 14, 15};
+  const int32_t expected[] = {134390589, 269126903, 539636700, 1084804976,
+                              -2103231037};
+  for (size_t j = 0; j < 5; j++) {
+    int32_t packedId = 0;
+    computePackedTileIds(lon, lat, 1, tileLevels[j], &packedId);
+    EXPECT_EQ(expected[j], packedId);
+  }
+}
+
+TEST(NDSTEST, testBatchPackedTileIdsInvalidInputIsFatal) {
+  std::vector<int32_t> lon(9, 0), lat(9, 0), packedIds(9);
+  EXPECT_DEATH(computePackedTileIds(lon.data(), lat.data(), 9, 16,
+                                    packedIds.data()),
+               "Tile level");
+  lat[7] = kMaxLatitude + 1;
+  EXPECT_DEATH(computePackedTileIds(lon.data(), lat.data(), 9, 13,
+                                    packedIds.data()),
+               "Latitude value");
+  std::vector<double> wgsLon(9, 10.0), wgsLat(9, 10.0);
+  wgsLon[3] = -180.5;
+  EXPECT_DEATH(computePackedTileIds(wgsLon.data(), wgsLat.data(), 9, 13,
+                                    packedIds.data()),
+               "longitude value");
+}
+
+TEST(NDSTEST, testBatchPackedTileIdDecodingMatchesTile) {
+  std::mt19937 rng(6);
+  std::vector<int32_t> ids = {0,       0x7FFF,        1 << 16,
+                              -1,      kMaxLongitude, kMinLongitude,
+                              539636700, -2103231037};
+  while (ids.size() < 1043) {
+    // Spread the IDs over all levels.
+    ids.push_back((int32_t)(rng() >> (rng() % 17)));
+  }
+  size_t n = ids.size();
+  for (SimdLevel level : kAllLevels) {
+    std::vector<int32_t> tileLevels(n), tileNumbers(n);
+    size_t invalid = decodePackedTileIds(ids.data(), n, tileLevels.data(),
+                                         tileNumbers.data(), level);
+    size_t expectedInvalid = 0;
+    for (size_t i = 0; i < n; i++) {
+      int expectedLevel = NdsTile::extractLevel(ids[i]);
+      ASSERT_EQ(expectedLevel, tileLevels[i])
+          << "level " << (int)level << " id " << ids[i];
+      if (expectedLevel < 0) {
+        expectedInvalid++;
+        ASSERT_EQ(ids[i] ^ (1 << 15), tileNumbers[i]);
+        continue;
+      }
+      NdsTile expected(ids[i]);
+      ASSERT_EQ(expected.tileNumber(), tileNumbers[i])
+          << "level " << (int)level << " id " << ids[i];
+    }
+    EXPECT_EQ(expectedInvalid, invalid) << "level " << (int)level;
+    EXPECT_LE(2u, invalid);
+  }
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
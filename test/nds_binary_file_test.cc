@@ -0,0 +1,179 @@
+#include "nds/nds_binary_file.h"
+//
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+//
+#include "nds/nds_tile.h"
+
+namespace nds {
+namespace {
+std::string tempPath(const char *name) {
+  return testing::TempDir() + name + std::to_string(getpid()) + ".ndsb";
+}
+
+std::vector<uint8_t> readFile(const std::string &path) {
+  std::vector<uint8_t> data;
+  FILE *f = std::fopen(path.c_str(), "rb");
+  int c;
+  while ((c = std::fgetc(f)) != EOF) {
+    data.push_back((uint8_t)c);
+  }
+  std::fclose(f);
+  return data;
+}
+} // namespace
+
+TEST(NDSTEST, testBinaryFileRoundTrip) {
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int32_t> lon(INT32_MIN, INT32_MAX);
+  std::uniform_int_distribution<int32_t> lat(-(1 << 30), (1 << 30) - 1);
+  std::vector<NdsCoordinate> coords;
+  std::vector<int64_t> codes;
+  for (int i = 0; i < 10007; i++) {
+    coords.emplace_back(lon(rng), lat(rng));
+    codes.push_back(coords.back().getMortonCode());
+  }
+  std::vector<int32_t> ids = {NdsTile(13, 8633).packedId(),
+                              NdsTile(15, 0).packedId(),
+                              NdsTile(0, 1).packedId()};
+  std::string path = tempPath("round_trip");
+  {
+    BinaryFileWriter writer(path);
+    writer.addCoordinates(coords);
+    writer.addMortonCodes(codes.data(), codes.size());
+    writer.addPackedTileIds(ids.data(), ids.size());
+    EXPECT_EQ(Status::kOk, writer.finish());
+  }
+
+  Result<BinaryFile> file = BinaryFile::open(path);
+  ASSERT_TRUE(file);
+  ASSERT_EQ(4u, file.value().sections().size());
+  Span<int32_t> lons = file.value().longitudes();
+  Span<int32_t> lats = file.value().latitudes();
+  Span<int64_t> morton = file.value().mortonCodes();
+  ASSERT_EQ(coords.size(), lons.size);
+  ASSERT_EQ(coords.size(), lats.size);
+  ASSERT_EQ(codes.size(), morton.size);
+  for (size_t i = 0; i < coords.size(); i++) {
+    ASSERT_EQ(coords[i].longitude(), lons[i]);
+    ASSERT_EQ(coords[i].latitude(), lats[i]);
+    ASSERT_EQ(codes[i], morton[i]);
+  }
+  EXPECT_EQ(ids,
+            std::vector<int32_t>(file.value().packedTileIds().begin(),
+                                 file.value().packedTileIds().end()));
+  // The arrays are aligned for vector loads.
+  for (const BinarySection &s : file.value().sections()) {
+    EXPECT_EQ(0u, s.offset % 64);
+  }
+  EXPECT_EQ(0u, (uintptr_t)morton.data % 64);
+
+  // Moving keeps the mapping.
+  BinaryFile moved = std::move(file.value());
+  EXPECT_EQ(coords[0].longitude(), moved.longitudes()[0]);
+  EXPECT_TRUE(moved.packedTileIds(13).empty());
+  std::remove(path.c_str());
+}
+
+TEST(NDSTEST, testBinaryFileTileSetLevels) {
+  TileSet tiles;
+  for (int nr = 0; nr < 10000; nr++) {
+    tiles.insert(NdsTile(13, nr * 7));
+  }
+  tiles.insert(NdsTile(2, 5));
+  tiles.insert(NdsTile(15, 1 << 30));
+  std::string path = tempPath("tile_set");
+  {
+    BinaryFileWriter writer(path);
+    writer.addTileSet(tiles);
+  }
+
+  Result<BinaryFile> file = BinaryFile::open(path);
+  ASSERT_TRUE(file);
+  EXPECT_EQ(3u, file.value().sections().size());
+  size_t count = 0;
+  for (int level = 0; level <= kMaxLevel; level++) {
+    std::vector<int32_t> expected;
+    tiles.level(level).forEach(
+        [&](int nr) { expected.push_back(NdsTile(level, nr).packedId()); });
+    Span<int32_t> ids = file.value().packedTileIds(level);
+    EXPECT_EQ(expected, std::vector<int32_t>(ids.begin(), ids.end()));
+    count += ids.size;
+  }
+  EXPECT_EQ(10002u, count);
+  std::remove(path.c_str());
+}
+
+TEST(NDSTEST, testBinaryFileMalformed) {
+  std::string path = tempPath("malformed");
+  std::vector<int64_t> codes(100, 42);
+  {
+    BinaryFileWriter writer(path);
+    writer.addMortonCodes(codes.data(), codes.size());
+  }
+  std::vector<uint8_t> bytes = readFile(path);
+  std::remove(path.c_str());
+  // 8 byte aligned copies, as required by parse().
+  auto parse = [](const std::vector<uint8_t> &data) {
+    std::vector<int64_t> aligned((data.size() + 7) / 8);
+    if (!data.empty()) {
+      std::memcpy(aligned.data(), data.data(), data.size());
+    }
+    return BinaryFile::parse(reinterpret_cast<const uint8_t *>(aligned.data()),
+                             data.size())
+        .status();
+  };
+  EXPECT_EQ(Status::kOk, parse(bytes));
+  // Misaligned data would give misaligned arrays.
+  std::vector<int64_t> shifted(bytes.size() / 8 + 2);
+  uint8_t *misaligned = reinterpret_cast<uint8_t *>(shifted.data()) + 4;
+  std::memcpy(misaligned, bytes.data(), bytes.size());
+  EXPECT_EQ(Status::kInvalidData,
+            BinaryFile::parse(misaligned, bytes.size()).status());
+
+  // Every truncation is detected.
+  for (size_t size = 0; size < bytes.size(); size++) {
+    std::vector<uint8_t> truncated(bytes.begin(), bytes.begin() + size);
+    ASSERT_EQ(Status::kInvalidData, parse(truncated)) << size;
+  }
+  std::vector<uint8_t> bad = bytes;
+  bad[0] = 'X';
+  EXPECT_EQ(Status::kInvalidData, parse(bad));
+  bad = bytes;
+  bad[4] = 2; // version
+  EXPECT_EQ(Status::kInvalidData, parse(bad));
+  size_t table = bytes.size() - 32;
+  bad = bytes;
+  bad[table] = 9; // type
+  EXPECT_EQ(Status::kInvalidData, parse(bad));
+  bad = bytes;
+  bad[table + 8] = 4; // element size
+  EXPECT_EQ(Status::kInvalidData, parse(bad));
+  bad = bytes;
+  bad[table + 16] = 65; // offset
+  EXPECT_EQ(Status::kInvalidData, parse(bad));
+  bad = bytes;
+  bad[table + 31] = 0x80; // count
+  EXPECT_EQ(Status::kInvalidData, parse(bad));
+
+  EXPECT_EQ(Status::kIoError, BinaryFile::open(path).status());
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
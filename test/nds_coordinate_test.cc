@@ -2,6 +2,7 @@
 //
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <limits>
 
 namespace nds {
 TEST(NDSTEST, testConstructor) {
@@ -99,6 +100,47 @@ TEST(NDSTEST, testNDSCoordinateMortonCodeComputationCornerCases) {
   EXPECT_EQ(0L, c.getMortonCode());
 }
 
+TEST(NDSTEST, testNonFatalFactories) {
+  Result<NdsCoordinate> c = NdsCoordinate::create(2.2945, 48.858222);
+  ASSERT_TRUE(c.ok());
+  EXPECT_EQ(27374451, c.value().longitude());
+  EXPECT_EQ(582901293, c.value().latitude());
+  EXPECT_EQ(Status::kInvalidLongitude,
+            NdsCoordinate::create(180.5, 0.0).status());
+  EXPECT_EQ(Status::kInvalidLatitude,
+            NdsCoordinate::create(0.0, -90.5).status());
+
+  c = NdsCoordinate::create(kMinLongitude, kMaxLatitude);
+  ASSERT_TRUE(c);
+  EXPECT_TRUE(c.value() == NdsCoordinate(kMinLongitude, kMaxLatitude));
+  EXPECT_FALSE(NdsCoordinate::create(0, kMaxLatitude + 1));
+  EXPECT_EQ(Status::kInvalidLatitude,
+            NdsCoordinate::create(0, kMinLatitude - 1).status());
+
+  Result<Wgs84Coordinate> w = Wgs84Coordinate::create(-74.044444, 40.689167);
+  ASSERT_TRUE(w.ok());
+  EXPECT_EQ(-74.044444, w.value().longitude());
+  EXPECT_EQ(Status::kInvalidLongitude,
+            Wgs84Coordinate::create(-181.0, 0.0).status());
+  EXPECT_EQ(Status::kInvalidLatitude,
+            Wgs84Coordinate::create(0.0, 91.0).status());
+  LOG(INFO) << statusMessage(Wgs84Coordinate::create(0.0, 91.0).status());
+}
+
+TEST(NDSTEST, testNonFatalFactoriesNonFinite) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  for (double v : {nan, inf, -inf}) {
+    EXPECT_EQ(Status::kInvalidLongitude,
+              NdsCoordinate::create(v, 10.0).status());
+    EXPECT_EQ(Status::kInvalidLatitude,
+              NdsCoordinate::create(10.0, v).status());
+    EXPECT_EQ(Status::kInvalidLongitude,
+              Wgs84Coordinate::create(v, 10.0).status());
+    EXPECT_EQ(Status::kInvalidLatitude,
+              Wgs84Coordinate::create(10.0, v).status());
+  }
+}
 } // namespace nds
 int main(int argc, char **argv) {
   google::InitGoogleLogging(argv[0]);
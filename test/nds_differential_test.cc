@@ -0,0 +1,97 @@
+#include "nds_differential.h"
+//
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace nds {
+namespace {
+template <typename T> void append(std::vector<uint8_t> *buffer, T value) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+  buffer->insert(buffer->end(), bytes, bytes + sizeof(T));
+}
+} // namespace
+
+TEST(NDSTEST, testDifferentialRandomBuffers) {
+  LOG(INFO) << "Max SIMD level: " << (int)maxSimdLevel()
+            << ", BMI2 Morton path: " << morton::bmi2Supported();
+  std::mt19937 rng(20);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<size_t> length(0, 2048);
+  for (int run = 0; run < 2000; run++) {
+    std::vector<uint8_t> buffer(length(rng));
+    for (uint8_t &b : buffer) {
+      b = (uint8_t)byte(rng);
+    }
+    std::string mismatch =
+        differential::check(buffer.data(), buffer.size());
+    ASSERT_TRUE(mismatch.empty()) << "run " << run << ": " << mismatch;
+  }
+}
+
+TEST(NDSTEST, testDifferentialEdgeCases) {
+  std::vector<uint8_t> buffer;
+  append<uint16_t>(&buffer, 0);
+  // All WGS84 edge value combinations.
+  for (uint64_t lon = 0; lon < 8; lon++) {
+    for (uint64_t lat = 0; lat < 8; lat++) {
+      append<uint8_t>(&buffer, 0);
+      append<uint8_t>(&buffer, 0);
+      append<uint64_t>(&buffer, lon);
+      append<uint8_t>(&buffer, 0);
+      append<uint64_t>(&buffer, lat);
+    }
+  }
+  // All NDS edge value combinations, the latitude is clamped.
+  for (uint32_t lon = 0; lon < 7; lon++) {
+    for (uint32_t lat = 0; lat < 7; lat++) {
+      append<uint8_t>(&buffer, 0x31);
+      append<uint32_t>(&buffer, lon);
+      append<uint32_t>(&buffer, lat);
+    }
+  }
+  // Morton codes with the sign bits set in all combinations, including the
+  // inadmissible bit 63.
+  for (uint64_t high = 0; high < 8; high++) {
+    for (uint64_t low : {0ULL, 1ULL, 2ULL, 0x1FFFFFFFFFFFFFFFULL}) {
+      append<uint8_t>(&buffer, 2);
+      append<uint64_t>(&buffer, high << 61 | low);
+    }
+  }
+  // Packed IDs with the level bits of all levels, level 15 uses the sign
+  // bit, and without level bit.
+  for (int level = -1; level <= kMaxLevel; level++) {
+    uint32_t levelBit = level < 0 ? 0 : 1u << (16 + level);
+    for (uint32_t nr : {0u, 1u, levelBit - 1, 0xFFFFu}) {
+      append<uint8_t>(&buffer, 3);
+      append<uint32_t>(&buffer, levelBit | (nr & (levelBit - 1)));
+    }
+  }
+  std::string mismatch = differential::check(buffer.data(), buffer.size());
+  EXPECT_TRUE(mismatch.empty()) << mismatch;
+
+  differential::Values v =
+      differential::decodeValues(buffer.data(), buffer.size());
+  EXPECT_EQ(64u, v.lon.size());
+  EXPECT_EQ(49u, v.ndsLon.size());
+  EXPECT_EQ(32u, v.morton.size());
+  EXPECT_EQ(68u, v.packedIds.size());
+  EXPECT_EQ(16u, v.levels.size());
+}
+
+TEST(NDSTEST, testDifferentialEmptyInput) {
+  EXPECT_TRUE(differential::check(nullptr, 0).empty());
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
@@ -0,0 +1,263 @@
+#include "nds/nds_geojson.h"
+//
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+//
+#include "configor/json.hpp"
+#include "nds/nds_tile_cover.h"
+
+namespace nds {
+namespace {
+/*
+ * The document based serialization the writer replaces.
+ */
+std::string pointReference(const Wgs84Coordinate &coord) {
+  configor::json geojson;
+  geojson["type"] = "Feature";
+  geojson["properties"] = {};
+  geojson["geometry"]["type"] = "Point";
+  geojson["geometry"]["coordinates"] = {
+      {coord.longitude(), coord.latitude()}};
+  return geojson.dump();
+}
+
+std::string polygonReference(const Wgs84Bbox &bbox) {
+  configor::json geojson;
+  geojson["type"] = "Feature";
+  geojson["properties"] = {};
+  geojson["geometry"]["type"] = "Polygon";
+  geojson["geometry"]["coordinates"] = {{bbox.west(), bbox.south()},
+                                        {bbox.east(), bbox.south()},
+                                        {bbox.east(), bbox.north()},
+                                        {bbox.west(), bbox.north()},
+                                        {bbox.west(), bbox.south()}};
+  return geojson.dump();
+}
+} // namespace
+
+TEST(NDSTEST, testGeoJsonNumbers) {
+  const double values[] = {0.0,
+                           -0.0,
+                           1.0,
+                           -180.0,
+                           180.0,
+                           90.0,
+                           0.1,
+                           1e-7,
+                           -1e-300,
+                           -2.2250738585072014e-308,
+                           11.49169922410124,
+                           -74.04444399999999,
+                           std::nextafter(180.0, 0.0)};
+  for (double value : values) {
+    char buffer[geojson::kMaxNumberSize];
+    std::string text(buffer, geojson::writeNumber(value, buffer));
+    configor::json reference = value;
+    EXPECT_EQ(reference.dump(), text) << value;
+    // The shortest representation reads back as the same value.
+    EXPECT_EQ(value, std::strtod(text.c_str(), nullptr));
+
+    for (int decimals : {0, 1, 7, geojson::kMaxDecimals}) {
+      text.assign(buffer, geojson::writeNumber(value, buffer, decimals));
+      EXPECT_EQ(reference.dump(configor::json::writer::args(0, ' ', false, 0,
+                                                            decimals)),
+                text)
+          << value << " " << decimals;
+    }
+  }
+
+  char buffer[geojson::kMaxNumberSize];
+  EXPECT_EQ("11.575", std::string(buffer, geojson::writeNumber(
+                                              11.575000000001, buffer, 7)));
+  EXPECT_EQ("-74.0444444", std::string(buffer, geojson::writeNumber(
+                                                   -74.04444444, buffer, 7)));
+  EXPECT_EQ("100.0",
+            std::string(buffer, geojson::writeNumber(100.4, buffer, 0)));
+  EXPECT_EQ("0.1", std::string(buffer, geojson::writeNumber(0.1, buffer)));
+  EXPECT_EQ("1e-07", std::string(buffer, geojson::writeNumber(1e-7, buffer)));
+  EXPECT_EQ("-0.0", std::string(buffer, geojson::writeNumber(-0.0, buffer)));
+}
+
+TEST(NDSTEST, testGeoJsonDecimals) {
+  NdsTile tile(13, Wgs84Coordinate(11.575, 48.137));
+  std::string shortest, fixed;
+  geojson::writeTile(tile, &shortest);
+  geojson::writeTile(tile, &fixed, 7);
+  EXPECT_EQ(0u, fixed.find("{\"geometry\":{\"coordinates\":[[11.5576172,"));
+  EXPECT_LT(fixed.size(), shortest.size());
+
+  Wgs84Bbox bbox = tile.getBBox().toWGS84();
+  configor::json reference;
+  reference["type"] = "Feature";
+  reference["properties"] = {};
+  reference["geometry"]["type"] = "Polygon";
+  reference["geometry"]["coordinates"] = {{bbox.west(), bbox.south()},
+                                          {bbox.east(), bbox.south()},
+                                          {bbox.east(), bbox.north()},
+                                          {bbox.west(), bbox.north()},
+                                          {bbox.west(), bbox.south()}};
+  EXPECT_EQ(reference.dump(configor::json::writer::args(0, ' ', false, 0, 7)),
+            fixed);
+
+  std::ostringstream stream;
+  geojson::FeatureCollectionWriter(stream, geojson::kNoProperties,
+                                   geojson::FeatureCollectionWriter::
+                                       kDefaultChunkSize,
+                                   7)
+      .add(tile);
+  EXPECT_EQ("{\"features\":[" + fixed + "],\"type\":\"FeatureCollection\"}",
+            stream.str());
+}
+
+TEST(NDSTEST, testGeoJsonMatchesDocument) {
+  std::mt19937_64 rng(21);
+  std::uniform_real_distribution<double> lonDist(-180.0, 180.0);
+  std::uniform_real_distribution<double> latDist(-90.0, 90.0);
+  for (int i = 0; i < 2000; i++) {
+    Wgs84Coordinate coord(lonDist(rng), latDist(rng));
+    EXPECT_EQ(pointReference(coord), coord.toGeoJSON());
+
+    double south = latDist(rng), west = lonDist(rng);
+    Wgs84Bbox bbox(south + 0.5, west + 0.25, south, west);
+    EXPECT_EQ(polygonReference(bbox), bbox.toGeoJSON());
+  }
+  Wgs84Coordinate corner(-180.0, 90.0);
+  EXPECT_EQ(pointReference(corner), corner.toGeoJSON());
+  EXPECT_EQ("{\"geometry\":{\"coordinates\":[[-180.0,90.0]],"
+            "\"type\":\"Point\"},\"properties\":null,\"type\":\"Feature\"}",
+            corner.toGeoJSON());
+}
+
+TEST(NDSTEST, testGeoJsonTile) {
+  for (int level : {0, 1, 13, 15}) {
+    NdsTile tile(level, Wgs84Coordinate(11.575, 48.137));
+    std::string expected = polygonReference(tile.getBBox().toWGS84());
+    EXPECT_EQ(expected, tile.toGeoJSON());
+
+    char buffer[geojson::kMaxPolygonSize];
+    EXPECT_EQ(expected,
+              std::string(buffer, geojson::writeTile(tile, buffer)));
+
+    // The string variant appends.
+    std::string text = "[";
+    geojson::writeTile(tile, &text);
+    EXPECT_EQ("[" + expected, text);
+
+    std::ostringstream stream;
+    geojson::writeTile(tile, stream);
+    geojson::writePoint(tile.getCenter().toWGS84(), stream);
+    EXPECT_EQ(expected + tile.getCenter().toWGS84().toGeoJSON(), stream.str());
+  }
+}
+
+TEST(NDSTEST, testFeatureCollection) {
+  Wgs84Coordinate point(11.575, 48.137);
+  Wgs84Bbox bbox(48.2, 11.7, 48.1, 11.5);
+  NdsTile tile(13, point);
+  std::string expected = "{\"features\":[" + point.toGeoJSON() + "," +
+                         bbox.toGeoJSON() + "," + tile.toGeoJSON() +
+                         "],\"type\":\"FeatureCollection\"}";
+  std::ostringstream stream;
+  {
+    geojson::FeatureCollectionWriter writer(stream);
+    writer.add(point);
+    writer.add(bbox);
+    writer.add(tile);
+    EXPECT_EQ(3u, writer.size());
+  }
+  EXPECT_EQ(expected, stream.str());
+
+  std::ostringstream empty;
+  EXPECT_EQ(Status::kOk, geojson::FeatureCollectionWriter(empty).finish());
+  EXPECT_EQ("{\"features\":[],\"type\":\"FeatureCollection\"}", empty.str());
+}
+
+TEST(NDSTEST, testFeatureCollectionTileProperties) {
+  NdsTile tile(15, Wgs84Coordinate(-74.044444, 40.689167));
+  std::ostringstream stream;
+  geojson::FeatureCollectionWriter writer(stream, geojson::kAllProperties);
+  writer.add(tile);
+  writer.add(tile, -42);
+  ASSERT_EQ(Status::kOk, writer.finish());
+  // Ignored after finish().
+  writer.add(tile);
+  EXPECT_EQ(2u, writer.size());
+
+  configor::json collection = configor::json::parse(stream.str());
+  EXPECT_EQ("FeatureCollection", collection["type"].as_string());
+  ASSERT_EQ(2u, collection["features"].size());
+  configor::json feature = collection["features"][1];
+  std::string geometry = tile.toGeoJSON();
+  geometry.erase(geometry.find("\"properties\""));
+  EXPECT_EQ(0u, stream.str().find("{\"features\":[" + geometry +
+                                  "\"properties\":{\"level\":15,"));
+  EXPECT_EQ(-42, feature["properties"]["count"].as_integer());
+  EXPECT_EQ(15, feature["properties"]["level"].as_integer());
+  EXPECT_EQ(tile.packedId(), feature["properties"]["packedId"].as_integer());
+  EXPECT_EQ(tile.tileNumber(),
+            feature["properties"]["tileNumber"].as_integer());
+  EXPECT_EQ(3u, collection["features"][0]["properties"].size());
+
+  std::ostringstream levelOnly;
+  geojson::FeatureCollectionWriter(levelOnly, geojson::kLevel).add(tile);
+  EXPECT_NE(std::string::npos,
+            levelOnly.str().find("\"properties\":{\"level\":15},"));
+}
+
+TEST(NDSTEST, testFeatureCollectionChunks) {
+  Wgs84Bbox area(48.3, 11.8, 48.0, 11.3);
+  std::vector<TileRange> ranges = coverRanges(area, 13);
+  TileSet set;
+  for (const TileRange &range : ranges) {
+    set.insert(13, range);
+  }
+  std::vector<NdsTile> tiles;
+  set.forEach([&](const NdsTile &tile) { tiles.push_back(tile); });
+
+  std::ostringstream reference;
+  {
+    geojson::FeatureCollectionWriter writer(reference);
+    writer.add(tiles.begin(), tiles.end());
+  }
+  for (size_t chunkSize : {(size_t)0, (size_t)100, (size_t)4096}) {
+    std::ostringstream stream;
+    geojson::FeatureCollectionWriter writer(stream, geojson::kNoProperties,
+                                            chunkSize);
+    for (const TileRange &range : ranges) {
+      writer.add(13, range);
+    }
+    EXPECT_EQ(tiles.size(), writer.size());
+    // Only the last, incomplete chunk is buffered.
+    EXPECT_LT(reference.str().size() - stream.str().size(),
+              chunkSize + geojson::kMaxPolygonSize + 64);
+    writer.finish();
+    EXPECT_EQ(reference.str(), stream.str()) << chunkSize;
+  }
+
+  std::ostringstream fromSet;
+  geojson::FeatureCollectionWriter(fromSet).add(set);
+  EXPECT_EQ(reference.str(), fromSet.str());
+}
+
+TEST(NDSTEST, testFeatureCollectionStreamError) {
+  std::ofstream file("/nonexistent/directory/tiles.geojson");
+  geojson::FeatureCollectionWriter writer(file);
+  writer.add(Wgs84Coordinate(0.0, 0.0));
+  EXPECT_EQ(Status::kIoError, writer.finish());
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
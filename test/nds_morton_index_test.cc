@@ -0,0 +1,167 @@
+#include "nds/nds_morton_index.h"
+//
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace nds {
+namespace {
+/*
+ * Random points, a third of them clustered around Munich.
+ */
+std::vector<NdsCoordinate> randomPoints(size_t count, std::mt19937 *rng) {
+  std::uniform_int_distribution<int> lonDist(kMinLongitude, kMaxLongitude);
+  std::uniform_int_distribution<int> latDist(kMinLatitude, kMaxLatitude);
+  std::normal_distribution<double> near(0, 1e6);
+  NdsCoordinate munich(11.575, 48.137);
+  std::vector<NdsCoordinate> points;
+  for (size_t i = 0; i < count; i++) {
+    if (i % 3 == 0) {
+      points.emplace_back(munich.longitude() + (int)near(*rng),
+                          munich.latitude() + (int)near(*rng));
+    } else {
+      points.emplace_back(lonDist(*rng), latDist(*rng));
+    }
+  }
+  return points;
+}
+
+MortonIndex buildIndex(const std::vector<NdsCoordinate> &points) {
+  std::vector<MortonRecord> records;
+  for (size_t i = 0; i < points.size(); i++) {
+    records.push_back({points[i].getMortonCode(), i});
+  }
+  return MortonIndex(records);
+}
+
+bool inBbox(const NdsBbox &b, const NdsCoordinate &c) {
+  bool inLon = b.west() <= b.east()
+                   ? b.west() <= c.longitude() && c.longitude() <= b.east()
+                   : b.west() <= c.longitude() || c.longitude() <= b.east();
+  return inLon && b.south() <= c.latitude() && c.latitude() <= b.north();
+}
+} // namespace
+
+TEST(NDSTEST, testIndexIsSortedAndComplete) {
+  std::mt19937 rng(15);
+  std::vector<NdsCoordinate> points = randomPoints(10000, &rng);
+  MortonIndex index = buildIndex(points);
+  ASSERT_EQ(points.size(), index.size());
+  std::vector<bool> seen(points.size());
+  for (size_t i = 0; i < index.size(); i++) {
+    if (i > 0) {
+      EXPECT_LE(index.morton(i - 1), index.morton(i));
+    }
+    EXPECT_TRUE(index.coordinate(i) == points[index.payload(i)]);
+    seen[index.payload(i)] = true;
+  }
+  EXPECT_EQ(points.size(), (size_t)std::count(seen.begin(), seen.end(), true));
+
+  // The batch constructor gives the same index.
+  std::vector<int32_t> lon, lat;
+  std::vector<uint64_t> payloads;
+  for (size_t i = 0; i < points.size(); i++) {
+    lon.push_back(points[i].longitude());
+    lat.push_back(points[i].latitude());
+    payloads.push_back(i);
+  }
+  MortonIndex batch(lon.data(), lat.data(), payloads.data(), points.size());
+  for (size_t i = 0; i < index.size(); i++) {
+    ASSERT_EQ(index.morton(i), batch.morton(i));
+    ASSERT_EQ(index.payload(i), batch.payload(i));
+  }
+  EXPECT_TRUE(MortonIndex().query(NdsBbox(1, 1, 0, 0)).empty());
+}
+
+TEST(NDSTEST, testTileQueryMatchesBruteForce) {
+  std::mt19937 rng(16);
+  std::vector<NdsCoordinate> points = randomPoints(20000, &rng);
+  MortonIndex index = buildIndex(points);
+  for (int level = 0; level <= kMaxLevel; level++) {
+    for (int n = 0; n < 20; n++) {
+      // Tiles containing a point, so most of them are not empty.
+      NdsTile tile(level, points[rng() % points.size()]);
+      IndexRange range = index.find(tile);
+      size_t expected = 0;
+      for (const NdsCoordinate &p : points) {
+        expected += tile.contains(p) ? 1 : 0;
+      }
+      ASSERT_EQ(expected, range.size()) << tile;
+      for (size_t i = range.first; i < range.last; i++) {
+        ASSERT_TRUE(tile.contains(index.coordinate(i)));
+      }
+    }
+  }
+}
+
+TEST(NDSTEST, testBboxQueryMatchesBruteForce) {
+  std::mt19937 rng(17);
+  std::vector<NdsCoordinate> points = randomPoints(20000, &rng);
+  MortonIndex index = buildIndex(points);
+  std::uniform_int_distribution<int> lonDist(kMinLongitude, kMaxLongitude);
+  std::uniform_int_distribution<int> latDist(kMinLatitude, kMaxLatitude);
+  std::uniform_int_distribution<int> sizeDist(0, 28);
+  for (int n = 0; n < 300; n++) {
+    // Sizes from a few units to the whole world.
+    int64_t width = 1LL << sizeDist(rng), height = 1LL << sizeDist(rng);
+    NdsCoordinate center = points[rng() % points.size()];
+    if (n % 4 == 0) {
+      center = NdsCoordinate(lonDist(rng), latDist(rng));
+    }
+    int west = (int)(uint32_t)(center.longitude() - width);
+    int east = (int)(uint32_t)(center.longitude() + width);
+    int south = (int)std::max<int64_t>(center.latitude() - height,
+                                       kMinLatitude);
+    int north = (int)std::min<int64_t>(center.latitude() + height,
+                                       kMaxLatitude);
+    NdsBbox bbox(north, east, south, west);
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < index.size(); i++) {
+      if (inBbox(bbox, index.coordinate(i))) {
+        expected.push_back(i);
+      }
+    }
+    ASSERT_EQ(expected, index.query(bbox)) << "west " << west << " east "
+                                           << east;
+    std::vector<IndexRange> candidates = index.candidates(bbox);
+    EXPECT_GE(50u, candidates.size());
+    for (size_t i = 1; i < candidates.size(); i++) {
+      EXPECT_LT(candidates[i - 1].last, candidates[i].first + 1);
+    }
+  }
+}
+
+TEST(NDSTEST, testWorldAndAntimeridianQuery) {
+  std::mt19937 rng(19);
+  std::vector<NdsCoordinate> points = randomPoints(5000, &rng);
+  MortonIndex index = buildIndex(points);
+  NdsBbox world(kMaxLatitude, kMaxLongitude, kMinLatitude, kMinLongitude);
+  EXPECT_EQ(points.size(), index.query(world).size());
+
+  // 20 degrees across the antimeridian, west > east.
+  NdsBbox across(NdsCoordinate(0.0, 40.0).latitude(),
+                 NdsCoordinate(-170.0, 0.0).longitude(),
+                 NdsCoordinate(0.0, -40.0).latitude(),
+                 NdsCoordinate(170.0, 0.0).longitude());
+  std::vector<size_t> expected;
+  for (size_t i = 0; i < index.size(); i++) {
+    if (inBbox(across, index.coordinate(i))) {
+      expected.push_back(i);
+    }
+  }
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(expected, index.query(across));
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
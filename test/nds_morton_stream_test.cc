@@ -0,0 +1,163 @@
+#include "nds/nds_morton_stream.h"
+//
+#include <algorithm>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace nds {
+namespace {
+/*
+ * A probe trace around Munich: points a few meters apart, with duplicates.
+ */
+std::vector<NdsCoordinate> trace(size_t count) {
+  std::mt19937 rng(7);
+  std::normal_distribution<double> step(0, 2e-5);
+  std::vector<NdsCoordinate> coords;
+  double lon = 11.575, lat = 48.137;
+  for (size_t i = 0; i < count; i++) {
+    lon += step(rng);
+    lat += step(rng);
+    coords.emplace_back(lon, lat);
+    if (i % 10 == 0) {
+      coords.push_back(coords.back());
+    }
+  }
+  return coords;
+}
+
+std::vector<int64_t> sortedCodes(const std::vector<NdsCoordinate> &coords) {
+  std::vector<int64_t> codes;
+  for (const NdsCoordinate &c : coords) {
+    codes.push_back(c.getMortonCode());
+  }
+  std::sort(codes.begin(), codes.end());
+  return codes;
+}
+} // namespace
+
+TEST(NDSTEST, testMortonStreamRoundTrip) {
+  std::vector<NdsCoordinate> coords = trace(100000);
+  std::vector<int64_t> expected = sortedCodes(coords);
+  MortonStream stream(coords);
+  EXPECT_EQ(expected.size(), stream.size());
+  EXPECT_EQ((expected.size() + MortonStream::kBlockSize - 1) /
+                MortonStream::kBlockSize,
+            stream.blockCount());
+  // A dense trace compresses well below the 8 bytes of a code.
+  EXPECT_LT(stream.byteSize(), expected.size() * 8 / 3);
+
+  std::vector<int64_t> codes;
+  stream.decode(&codes);
+  EXPECT_EQ(expected, codes);
+  std::vector<NdsCoordinate> decoded;
+  stream.decode(&decoded);
+  ASSERT_EQ(expected.size(), decoded.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(expected[i], decoded[i].getMortonCode());
+  }
+}
+
+TEST(NDSTEST, testMortonStreamExtremes) {
+  std::vector<int64_t> expected = {std::numeric_limits<int64_t>::min(), -1, 0,
+                                   0, std::numeric_limits<int64_t>::max()};
+  MortonStream stream(expected.data(), expected.size());
+  std::vector<int64_t> codes;
+  stream.decode(&codes);
+  EXPECT_EQ(expected, codes);
+  // A delta of 10 varint bytes.
+  expected.erase(expected.begin() + 1, expected.end() - 1);
+  codes.clear();
+  MortonStream(expected.data(), expected.size()).decode(&codes);
+  EXPECT_EQ(expected, codes);
+
+  MortonStream empty(nullptr, 0);
+  codes.clear();
+  empty.decode(&codes);
+  EXPECT_TRUE(codes.empty());
+  empty.find(0, 100, &codes);
+  EXPECT_TRUE(codes.empty());
+}
+
+TEST(NDSTEST, testMortonStreamFindTile) {
+  std::vector<NdsCoordinate> coords = trace(20000);
+  MortonStream stream(coords);
+  std::vector<int64_t> sorted = sortedCodes(coords);
+  for (int level : {10, 13, 15}) {
+    std::set<int> tileNumbers;
+    for (size_t i = 0; i < coords.size(); i += 97) {
+      tileNumbers.insert(NdsTile(level, coords[i]).tileNumber());
+    }
+    for (int nr : tileNumbers) {
+      NdsTile tile(level, nr);
+      std::vector<NdsCoordinate> expected;
+      for (int64_t code : sorted) {
+        if (tile.contains(NdsCoordinate(code))) {
+          expected.emplace_back(code);
+        }
+      }
+      std::vector<NdsCoordinate> found;
+      stream.find(tile, &found);
+      ASSERT_EQ(expected.size(), found.size()) << level << " " << nr;
+      ASSERT_FALSE(found.empty());
+      for (size_t i = 0; i < found.size(); i++) {
+        ASSERT_EQ(expected[i].getMortonCode(), found[i].getMortonCode());
+      }
+    }
+  }
+  // Duplicates spanning a block boundary.
+  std::vector<int64_t> codes(3 * MortonStream::kBlockSize, 5);
+  codes.push_back(6);
+  MortonStream dups(codes.data(), codes.size());
+  std::vector<int64_t> found;
+  dups.find(5, 5, &found);
+  EXPECT_EQ(3 * MortonStream::kBlockSize, found.size());
+}
+
+TEST(NDSTEST, testMortonStreamSerialize) {
+  MortonStream stream(trace(1000));
+  std::vector<uint8_t> bytes;
+  stream.serialize(&bytes);
+  Result<MortonStream> read = MortonStream::deserialize(bytes.data(),
+                                                        bytes.size());
+  ASSERT_TRUE(read);
+  std::vector<int64_t> expected, codes;
+  stream.decode(&expected);
+  read.value().decode(&codes);
+  EXPECT_EQ(expected, codes);
+
+  // Every truncation is detected.
+  for (size_t size = 0; size < bytes.size(); size++) {
+    ASSERT_FALSE(MortonStream::deserialize(bytes.data(), size)) << size;
+  }
+  std::vector<uint8_t> bad = bytes;
+  bad[0] = 'X';
+  EXPECT_FALSE(MortonStream::deserialize(bad.data(), bad.size()));
+  // An unterminated varint at the end of the first block.
+  bad = bytes;
+  size_t firstLength = bad[20] | bad[21] << 8;
+  bad[24 + firstLength - 1] |= 0x80;
+  EXPECT_FALSE(MortonStream::deserialize(bad.data(), bad.size()));
+  // A delta beyond the largest code.
+  std::vector<int64_t> large = {std::numeric_limits<int64_t>::max() - 1,
+                                std::numeric_limits<int64_t>::max()};
+  bad.clear();
+  MortonStream(large.data(), large.size()).serialize(&bad);
+  bad.back() = 2;
+  EXPECT_FALSE(MortonStream::deserialize(bad.data(), bad.size()));
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
@@ -0,0 +1,117 @@
+#include "nds/nds_morton.h"
+//
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <random>
+//
+#include "nds/nds_coordinate.h"
+
+namespace nds {
+namespace {
+void expectSameEncoding(int32_t lon, int32_t lat) {
+  int64_t expected = morton::encodeReference(lon, lat);
+  EXPECT_EQ(expected, morton::encodePortable(lon, lat))
+      << "lon: " << lon << " lat: " << lat;
+  EXPECT_EQ(expected, morton::encode(lon, lat))
+      << "lon: " << lon << " lat: " << lat;
+  if (morton::bmi2Supported()) {
+    EXPECT_EQ(expected, morton::encodeBmi2(lon, lat))
+        << "lon: " << lon << " lat: " << lat;
+  }
+}
+
+void expectSameDecoding(int64_t code) {
+  int32_t lon = 0, lat = 0;
+  morton::decodeReference(code, &lon, &lat);
+
+  int32_t fastLon = 0, fastLat = 0;
+  morton::decodePortable(code, &fastLon, &fastLat);
+  EXPECT_EQ(lon, fastLon) << "code: " << code;
+  EXPECT_EQ(lat, fastLat) << "code: " << code;
+
+  morton::decode(code, &fastLon, &fastLat);
+  EXPECT_EQ(lon, fastLon) << "code: " << code;
+  EXPECT_EQ(lat, fastLat) << "code: " << code;
+
+  if (morton::bmi2Supported()) {
+    morton::decodeBmi2(code, &fastLon, &fastLat);
+    EXPECT_EQ(lon, fastLon) << "code: " << code;
+    EXPECT_EQ(lat, fastLat) << "code: " << code;
+  }
+}
+} // namespace
+
+TEST(NDSTEST, testMortonEngineCornerCases) {
+  LOG(INFO) << "BMI2 Morton path: " << morton::bmi2Supported();
+  const int32_t values[] = {0,
+                            1,
+                            -1,
+                            kMaxLatitude,
+                            kMinLatitude,
+                            kMaxLongitude,
+                            kMinLongitude,
+                            kMaxLatitude + 1,
+                            kMinLatitude - 1};
+  for (int32_t lon : values) {
+    for (int32_t lat : values) {
+      expectSameEncoding(lon, lat);
+    }
+  }
+  const int64_t codes[] = {0L,
+                           1L,
+                           2305843009213693951L,
+                           6917529027641081856L,
+                           5380300354831952554L,
+                           3843071682022823253L,
+                           std::numeric_limits<int64_t>::max(),
+                           std::numeric_limits<int64_t>::min(),
+                           -1L};
+  for (int64_t code : codes) {
+    expectSameDecoding(code);
+  }
+}
+
+TEST(NDSTEST, testMortonEngineMatchesReference) {
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<int32_t> lonDist(kMinLongitude, kMaxLongitude);
+  std::uniform_int_distribution<int32_t> latDist(kMinLatitude, kMaxLatitude);
+  for (int i = 0; i < 100000; i++) {
+    expectSameEncoding(lonDist(rng), latDist(rng));
+    expectSameDecoding((int64_t)rng());
+  }
+}
+
+TEST(NDSTEST, testMortonEngineRoundTrip) {
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<int32_t> lonDist(kMinLongitude, kMaxLongitude);
+  std::uniform_int_distribution<int32_t> latDist(kMinLatitude, kMaxLatitude);
+  for (int i = 0; i < 100000; i++) {
+    int32_t lon = lonDist(rng), lat = latDist(rng);
+    int32_t decodedLon = 0, decodedLat = 0;
+    morton::decode(morton::encode(lon, lat), &decodedLon, &decodedLat);
+    EXPECT_EQ(lon, decodedLon);
+    EXPECT_EQ(lat, decodedLat);
+  }
+}
+
+TEST(NDSTEST, testMortonEngineIsConstexpr) {
+  static_assert(morton::encodePortable(0, 0) == 0L, "");
+  static_assert(morton::encodePortable(kMaxLongitude, kMaxLatitude) ==
+                    2305843009213693951L,
+                "");
+  static_assert(morton::encodePortable(kMinLongitude, kMinLatitude) ==
+                    6917529027641081856L,
+                "");
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
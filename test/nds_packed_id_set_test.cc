@@ -0,0 +1,68 @@
+#include "nds/nds_packed_id_set.h"
+//
+#include <algorithm>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace nds {
+
+TEST(NDSTEST, testPackedIdSetMatchesBinarySearch) {
+  std::mt19937 rng(16);
+  for (size_t size : {0, 1, 2, 3, 15, 16, 17, 31, 32, 33, 1000, 4097}) {
+    std::vector<int> ids;
+    for (size_t i = 0; i < size; i++) {
+      // Duplicates and negative (level 15) IDs included.
+      ids.push_back((int)(rng() % 3 == 0 ? rng() : rng() % 5000));
+    }
+    PackedIdSet set(ids);
+    std::vector<int> sorted = ids;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    ASSERT_EQ(sorted.size(), set.size());
+    ASSERT_EQ(sorted, set.sorted());
+    for (int id : ids) {
+      ASSERT_TRUE(set.contains(id)) << id;
+    }
+    for (int n = 0; n < 10000; n++) {
+      int id = (int)(n % 2 ? rng() : rng() % 5100);
+      ASSERT_EQ(std::binary_search(sorted.begin(), sorted.end(), id),
+                set.contains(id))
+          << id;
+    }
+    // The extremes of the value range.
+    for (int id : {std::numeric_limits<int>::min(),
+                   std::numeric_limits<int>::max(), 0, -1}) {
+      ASSERT_EQ(std::binary_search(sorted.begin(), sorted.end(), id),
+                set.contains(id));
+    }
+  }
+  EXPECT_FALSE(PackedIdSet().contains(0));
+}
+
+TEST(NDSTEST, testPackedIdSetFromTiles) {
+  std::vector<NdsTile> tiles = {NdsTile(539636700), NdsTile(13, 0),
+                                NdsTile(15, 1), NdsTile(0, 1),
+                                NdsTile(539636700)};
+  PackedIdSet set(tiles);
+  EXPECT_EQ(4u, set.size());
+  for (const NdsTile &tile : tiles) {
+    EXPECT_TRUE(set.contains(tile));
+  }
+  EXPECT_FALSE(set.contains(NdsTile(14, 0)));
+  EXPECT_FALSE(set.contains(NdsTile(0, 0)));
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
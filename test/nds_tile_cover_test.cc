@@ -0,0 +1,486 @@
+#include "nds/nds_tile_cover.h"
+//
+#include <algorithm>
+#include <cmath>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+
+namespace nds {
+namespace {
+/*
+ * Brute force reference: a tile intersects the box if its south west corner
+ * lies within the columns and rows of the box corners.
+ */
+std::set<int> bruteForceCover(const NdsBbox &bbox, int level) {
+  std::set<int> tiles;
+  int shift = 31 - level;
+  for (int nr = 0; nr < (1 << (2 * level + 1)); nr++) {
+    NdsCoordinate sw(NdsTile(level, nr).southWestAsMorton());
+    int col = sw.longitude() >> shift;
+    bool inCols = bbox.west() <= bbox.east()
+                      ? (bbox.west() >> shift) <= col &&
+                            col <= (bbox.east() >> shift)
+                      : (bbox.west() >> shift) <= col ||
+                            col <= (bbox.east() >> shift);
+    bool inRows = level == 0 || ((bbox.south() >> shift) <=
+                                     (sw.latitude() >> shift) &&
+                                 (sw.latitude() >> shift) <=
+                                     (bbox.north() >> shift));
+    if (inCols && inRows) {
+      tiles.insert(nr);
+    }
+  }
+  return tiles;
+}
+
+/*
+ * Liang-Barsky clipping: whether the segment from a to b intersects the
+ * inclusive bounding box grown by tolerance units on each side.
+ */
+bool segmentTouches(const NdsCoordinate &a, const NdsCoordinate &b,
+                    const NdsBbox &box, double tolerance) {
+  const double x = a.longitude(), y = a.latitude();
+  const double dx = (double)b.longitude() - x, dy = (double)b.latitude() - y;
+  const double p[4] = {-dx, dx, -dy, dy};
+  const double q[4] = {x - (box.west() - tolerance),
+                       box.east() + tolerance - x,
+                       y - (box.south() - tolerance),
+                       box.north() + tolerance - y};
+  double t0 = 0, t1 = 1;
+  for (int i = 0; i < 4; i++) {
+    if (p[i] == 0) {
+      if (q[i] < 0) {
+        return false;
+      }
+    } else if (p[i] < 0) {
+      t0 = std::max(t0, q[i] / p[i]);
+    } else {
+      t1 = std::min(t1, q[i] / p[i]);
+    }
+  }
+  return t0 <= t1;
+}
+
+bool lineTouches(const std::vector<NdsCoordinate> &line, const NdsBbox &box,
+                 double tolerance) {
+  for (size_t i = 0; i + 1 < line.size(); i++) {
+    if (segmentTouches(line[i], line[i + 1], box, tolerance)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::set<int> toSet(const std::vector<TileRange> &ranges) {
+  std::set<int> tiles;
+  for (const TileRange &range : ranges) {
+    for (int nr = range.first; nr <= range.last; nr++) {
+      tiles.insert(nr);
+    }
+  }
+  return tiles;
+}
+
+/*
+ * Plain floating point even-odd test as reference.
+ */
+bool insidePolygon(const std::vector<std::vector<NdsCoordinate>> &rings,
+                   double x, double y) {
+  bool inside = false;
+  for (const std::vector<NdsCoordinate> &ring : rings) {
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+      double xi = ring[i].longitude(), yi = ring[i].latitude();
+      double xj = ring[j].longitude(), yj = ring[j].latitude();
+      if ((yi > y) != (yj > y) &&
+          x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+        inside = !inside;
+      }
+    }
+  }
+  return inside;
+}
+
+/*
+ * Distance in meters from the center to the closest point of a tile, in the
+ * local equirectangular projection of the center.
+ */
+double distanceToTile(const NdsCoordinate &center, int level, int nr) {
+  const double kUnitsPerMeter = 2147483648.0 / 180 / (40075016.686 / 360);
+  NdsCoordinate sw(NdsTile(level, nr).southWestAsMorton());
+  double size = std::ldexp(1.0, 31 - level);
+  double south = level == 0 ? -1073741824.0 : sw.latitude();
+  double north = level == 0 ? 1073741824.0 : south + size;
+  double cx = center.longitude(), cy = center.latitude();
+  double dx = 1e300;
+  for (double shift : {-4294967296.0, 0.0, 4294967296.0}) {
+    double x = cx + shift;
+    dx = std::min(dx, std::max({0.0, sw.longitude() - x,
+                                x - (sw.longitude() + size)}));
+  }
+  double dy = std::max({0.0, south - cy, cy - north});
+  dx *= std::cos(cy / 2147483648.0 * M_PI);
+  return std::sqrt(dx * dx + dy * dy) / kUnitsPerMeter;
+}
+
+void expectValidRanges(const std::vector<TileRange> &ranges) {
+  for (size_t i = 0; i < ranges.size(); i++) {
+    EXPECT_LE(ranges[i].first, ranges[i].last);
+    if (i > 0) {
+      // Sorted, disjoint and not adjacent.
+      EXPECT_LT(ranges[i - 1].last + 1, ranges[i].first);
+    }
+  }
+}
+} // namespace
+
+TEST(NDSTEST, testCoverMatchesBruteForce) {
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<int> lonDist(kMinLongitude, kMaxLongitude);
+  std::uniform_int_distribution<int> latDist(kMinLatitude, kMaxLatitude);
+  for (int level = 0; level <= 6; level++) {
+    for (int i = 0; i < 50; i++) {
+      int lat1 = latDist(rng), lat2 = latDist(rng);
+      NdsBbox bbox(std::max(lat1, lat2), lonDist(rng), std::min(lat1, lat2),
+                   lonDist(rng));
+      std::vector<TileRange> ranges = coverRanges(bbox, level);
+      expectValidRanges(ranges);
+      std::set<int> expected = bruteForceCover(bbox, level);
+      std::vector<int> packedIds = coverPackedIds(bbox, level);
+      ASSERT_EQ(expected.size(), packedIds.size()) << "level " << level;
+      auto it = expected.begin();
+      for (int packedId : packedIds) {
+        NdsTile t(packedId);
+        ASSERT_EQ(level, t.level());
+        ASSERT_EQ(*it++, t.tileNumber()) << "level " << level << " " << bbox;
+      }
+    }
+  }
+}
+
+TEST(NDSTEST, testCoverContainsCornerTiles) {
+  // Barcelona area
+  NdsBbox bbox = NdsTile(539636700).getBBox();
+  std::vector<NdsTile> tiles = coverTiles(bbox, 13);
+  ASSERT_EQ(1u, tiles.size());
+  EXPECT_EQ(539636700, tiles[0].packedId());
+
+  tiles = coverTiles(bbox, 15);
+  EXPECT_EQ(16u, tiles.size());
+  for (NdsTile &t : tiles) {
+    EXPECT_EQ(539636700, NdsTile(13, t.getCenter()).packedId());
+  }
+
+  Wgs84Bbox world(90, 180, -90, -180);
+  EXPECT_EQ(2u, coverTiles(world, 0).size());
+  EXPECT_EQ(2048u, coverTiles(world, 5).size());
+  std::vector<TileRange> ranges = coverRanges(world, 15);
+  ASSERT_EQ(1u, ranges.size());
+  EXPECT_EQ(0, ranges[0].first);
+  EXPECT_EQ(kMaxLongitude, ranges[0].last);
+
+  // A box crossing the antimeridian, Fiji.
+  Wgs84Bbox fiji(-15.5, -178.0, -21.0, 176.5);
+  std::vector<NdsTile> fijiTiles = coverTiles(fiji, 10);
+  EXPECT_EQ(coverTiles(Wgs84Bbox(-15.5, 180, -21.0, 176.5), 10).size() +
+                coverTiles(Wgs84Bbox(-15.5, -178.0, -21.0, -180), 10).size(),
+            fijiTiles.size());
+  EXPECT_TRUE(coverTiles(NdsBbox(-1, 10, 1, 0), 10).empty());
+}
+
+TEST(NDSTEST, testCoverCountrySizedBox) {
+  // Germany at level 15, ~17 million tiles.
+  Wgs84Bbox germany(55.1, 15.1, 47.2, 5.8);
+  std::vector<TileRange> ranges = coverRanges(germany, 15);
+  expectValidRanges(ranges);
+  int64_t count = 0;
+  for (const TileRange &range : ranges) {
+    count += range.size();
+  }
+  NdsCoordinate ne(germany.east(), germany.north());
+  NdsCoordinate sw(germany.west(), germany.south());
+  int64_t cols = (ne.longitude() >> 16) - (sw.longitude() >> 16) + 1;
+  int64_t rows = (ne.latitude() >> 16) - (sw.latitude() >> 16) + 1;
+  EXPECT_EQ(cols * rows, count);
+}
+
+TEST(NDSTEST, testPolygonCoverOfRectangleMatchesBoxCover) {
+  // Corners off the tile grid, so no edge runs along a tile border.
+  NdsBbox bbox(400000003, 300000007, -100000009, -200000011);
+  std::vector<std::vector<NdsCoordinate>> rings = {
+      {bbox.southWest(), bbox.southEast(), bbox.northEast(),
+       bbox.northWest()}};
+  for (int level = 0; level <= 9; level++) {
+    PolygonCover cover = coverPolygon(rings, level);
+    expectValidRanges(cover.interior);
+    expectValidRanges(cover.boundary);
+    std::set<int> all = toSet(cover.interior);
+    for (int nr : toSet(cover.boundary)) {
+      EXPECT_TRUE(all.insert(nr).second) << "tile in both sets";
+    }
+    EXPECT_EQ(toSet(coverRanges(bbox, level)), all) << "level " << level;
+  }
+}
+
+TEST(NDSTEST, testPolygonCoverWithHoleMatchesSampling) {
+  // A triangle with a quadrilateral hole, in WGS84.
+  std::vector<std::vector<Wgs84Coordinate>> wgs84 = {
+      {Wgs84Coordinate(-20.3, -10.1), Wgs84Coordinate(60.7, 5.2),
+       Wgs84Coordinate(10.4, 70.9)},
+      {Wgs84Coordinate(5.5, 10.5), Wgs84Coordinate(25.5, 12.5),
+       Wgs84Coordinate(20.5, 30.5), Wgs84Coordinate(8.5, 25.5)}};
+  std::vector<std::vector<NdsCoordinate>> rings;
+  for (const auto &ring : wgs84) {
+    rings.emplace_back();
+    for (const Wgs84Coordinate &c : ring) {
+      rings.back().emplace_back(c.longitude(), c.latitude());
+    }
+  }
+  const int level = 7;
+  PolygonCover cover = coverPolygon(wgs84, level);
+  std::set<int> interior = toSet(cover.interior);
+  std::set<int> boundary = toSet(cover.boundary);
+  EXPECT_FALSE(interior.empty());
+  EXPECT_FALSE(boundary.empty());
+
+  // Each vertex lies in a boundary tile.
+  for (const auto &ring : rings) {
+    for (const NdsCoordinate &c : ring) {
+      EXPECT_EQ(1u, boundary.count(NdsTile(level, c).tileNumber()));
+    }
+  }
+  // The hole center is not covered.
+  EXPECT_EQ(0u, interior.count(
+                    NdsTile(level, Wgs84Coordinate(15, 20)).tileNumber()));
+
+  // Sample points in every tile: interior tiles are completely inside,
+  // uncovered tiles completely outside.
+  std::mt19937 rng(10);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  for (int nr = 0; nr < (1 << (2 * level + 1)); nr++) {
+    if (boundary.count(nr)) {
+      continue;
+    }
+    bool expected = interior.count(nr) > 0;
+    NdsBbox b = NdsTile(level, nr).getBBox();
+    for (int i = 0; i < 8; i++) {
+      double x = b.west() + unit(rng) * ((double)b.east() - b.west());
+      double y = b.south() + unit(rng) * ((double)b.north() - b.south());
+      ASSERT_EQ(expected, insidePolygon(rings, x, y)) << "tile " << nr;
+    }
+  }
+}
+
+TEST(NDSTEST, testPolygonCoverEmitsInteriorWithoutDescending) {
+  // Contains the level 2 tiles of the eastern hemisphere below 45°.
+  std::vector<std::vector<Wgs84Coordinate>> rings = {
+      {Wgs84Coordinate(-1, -89), Wgs84Coordinate(179, -89),
+       Wgs84Coordinate(179, 89), Wgs84Coordinate(-1, 89)}};
+  PolygonCover cover = coverPolygon(rings, 15);
+  ASSERT_FALSE(cover.interior.empty());
+  // Level 2 tile 0 is emitted as a single range of its level 15 descendants.
+  EXPECT_EQ(0, cover.interior[0].first);
+  EXPECT_LE((1 << 26) - 1, cover.interior[0].last);
+  std::vector<std::vector<NdsCoordinate>> empty;
+  EXPECT_TRUE(coverPolygon(empty, 10).interior.empty());
+}
+
+TEST(NDSTEST, testPolylineCoverIsSupercover) {
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> lonDist(-20000000, 20000000);
+  std::uniform_int_distribution<int> latDist(-20000000, 20000000);
+  for (int level : {0, 1, 8, 10}) {
+    for (int n = 0; n < 20; n++) {
+      std::vector<NdsCoordinate> line;
+      for (int v = 0; v < 4; v++) {
+        line.emplace_back(lonDist(rng), latDist(rng));
+      }
+      // Axis parallel and degenerate segments.
+      line.emplace_back(line.back().longitude() + 1234567,
+                        line.back().latitude());
+      line.push_back(line.back());
+      line.emplace_back(line.back().longitude(),
+                        line.back().latitude() - 7654321);
+      std::vector<TileRange> ranges = coverPolyline(line, level);
+      expectValidRanges(ranges);
+      std::set<int> tiles = toSet(ranges);
+      // Every point on the line lies in a covered tile.
+      for (size_t i = 0; i + 1 < line.size(); i++) {
+        for (int k = 0; k <= 1000; k++) {
+          double t = k / 1000.0;
+          NdsCoordinate p(
+              (int)std::floor(line[i].longitude() +
+                              t * ((double)line[i + 1].longitude() -
+                                   line[i].longitude())),
+              (int)std::floor(line[i].latitude() +
+                              t * ((double)line[i + 1].latitude() -
+                                   line[i].latitude())));
+          ASSERT_EQ(1u, tiles.count(NdsTile(level, p).tileNumber()))
+              << "level " << level;
+        }
+      }
+      // Every covered tile is touched by the line, up to rounding.
+      for (int nr : tiles) {
+        EXPECT_TRUE(lineTouches(line, NdsTile(level, nr).getBBox(), 1))
+            << "level " << level << " tile " << nr;
+      }
+    }
+  }
+  EXPECT_TRUE(coverPolyline(std::vector<NdsCoordinate>(), 10).empty());
+  NdsCoordinate single(24772607, 493486079);
+  std::vector<TileRange> ranges = coverPolyline({single}, 13);
+  ASSERT_EQ(1u, ranges.size());
+  EXPECT_EQ(NdsTile(13, single).tileNumber(), ranges[0].first);
+}
+
+TEST(NDSTEST, testPolylineCorridor) {
+  // Along the equator, level 13 tiles are ~2.4 km wide and 1 degree
+  // spans 45.5 of them.
+  std::vector<Wgs84Coordinate> line = {Wgs84Coordinate(10.0, 0.1),
+                                       Wgs84Coordinate(11.0, 0.1)};
+  std::set<int> narrow = toSet(coverPolyline(line, 13));
+  std::set<int> wide = toSet(coverPolyline(line, 13, 10000));
+  EXPECT_EQ(46u, narrow.size());
+  EXPECT_LT(narrow.size() * 4, wide.size());
+  for (int nr : narrow) {
+    EXPECT_EQ(1u, wide.count(nr));
+  }
+  // Every tile of the wide cover is within the corridor of the line.
+  std::vector<NdsCoordinate> ndsLine;
+  for (const Wgs84Coordinate &c : line) {
+    ndsLine.emplace_back(c.longitude(), c.latitude());
+  }
+  const double corridor = std::ceil(10000 / (40075016.686 / 360.0) *
+                                    (kLatitudeRange / 180.0) /
+                                    std::cos(0.2 * M_PI / 180.0)) +
+                          1;
+  for (int nr : wide) {
+    EXPECT_TRUE(lineTouches(ndsLine, NdsTile(13, nr).getBBox(), corridor))
+        << nr;
+  }
+  // 9.9 km north and south are inside the corridor, 25 km are not.
+  const double kDegreesPerKm = 1 / 111.32;
+  for (double km : {-9.9, 9.9}) {
+    Wgs84Coordinate c(10.5, 0.1 + km * kDegreesPerKm);
+    EXPECT_EQ(1u, wide.count(NdsTile(13, c).tileNumber())) << km;
+  }
+  for (double km : {-25.0, 25.0}) {
+    Wgs84Coordinate c(10.5, 0.1 + km * kDegreesPerKm);
+    EXPECT_EQ(0u, wide.count(NdsTile(13, c).tileNumber())) << km;
+  }
+  // West of the start, inside the box swept along the line.
+  EXPECT_EQ(1u, wide.count(
+                    NdsTile(13, Wgs84Coordinate(10.0 - 9.9 * kDegreesPerKm,
+                                                0.1))
+                        .tileNumber()));
+
+  // The corridor of a line at the antimeridian wraps to the western
+  // hemisphere.
+  std::vector<Wgs84Coordinate> dateLine = {Wgs84Coordinate(179.99, -0.1),
+                                           Wgs84Coordinate(179.99, 0.1)};
+  std::set<int> wrapped = toSet(coverPolyline(dateLine, 13, 10000));
+  for (double lon : {-179.95, 179.95}) {
+    EXPECT_EQ(1u, wrapped.count(
+                      NdsTile(13, Wgs84Coordinate(lon, 0.0)).tileNumber()))
+        << lon;
+  }
+  EXPECT_EQ(0u, wrapped.count(
+                    NdsTile(13, Wgs84Coordinate(-179.5, 0.0)).tileNumber()));
+
+  // A ~1000 km route from Hamburg to Munich with a 2 km corridor.
+  std::vector<Wgs84Coordinate> route;
+  for (int i = 0; i <= 1000; i++) {
+    double t = i / 1000.0;
+    route.emplace_back(9.99 + t * (11.58 - 9.99) + 0.2 * std::sin(t * 20),
+                       53.55 + t * (48.14 - 53.55));
+  }
+  std::set<int> routeTiles = toSet(coverPolyline(route, 13, 2000));
+  for (const Wgs84Coordinate &c : route) {
+    EXPECT_EQ(1u, routeTiles.count(NdsTile(13, c).tileNumber()));
+  }
+}
+
+TEST(NDSTEST, testRadiusCoverMatchesBruteForce) {
+  std::mt19937 rng(12);
+  std::uniform_int_distribution<int> lonDist(kMinLongitude, kMaxLongitude);
+  std::uniform_int_distribution<int> latDist(kMinLatitude, kMaxLatitude);
+  std::uniform_real_distribution<double> radiusDist(0, 3000000);
+  for (int level : {0, 1, 3, 6, 8}) {
+    for (int n = 0; n < 30; n++) {
+      NdsCoordinate center(lonDist(rng), latDist(rng));
+      // Centers next to the antimeridian.
+      if (n % 3 == 0) {
+        center = NdsCoordinate(kMaxLongitude - n * 1000, center.latitude());
+      }
+      double radius = n == 0 ? 0 : radiusDist(rng) / (1 << level / 2);
+      std::vector<TileRange> ranges = coverRadius(center, radius, level);
+      expectValidRanges(ranges);
+      std::set<int> tiles = toSet(ranges);
+      EXPECT_EQ(1u, tiles.count(NdsTile(level, center).tileNumber()));
+      for (int nr = 0; nr < (1 << (2 * level + 1)); nr++) {
+        double distance = distanceToTile(center, level, nr);
+        if (distance < radius * (1 - 1e-9)) {
+          ASSERT_EQ(1u, tiles.count(nr)) << "level " << level << " nr " << nr;
+        } else if (distance > radius * (1 + 1e-9) + 1) {
+          ASSERT_EQ(0u, tiles.count(nr)) << "level " << level << " nr " << nr;
+        }
+      }
+    }
+  }
+  // Radii beyond the earth cover everything.
+  std::vector<TileRange> all = coverRadius(Wgs84Coordinate(0, 0), 3e7, 4);
+  ASSERT_EQ(1u, all.size());
+  EXPECT_EQ(TileRange({0, (1 << 9) - 1}), all[0]);
+}
+
+TEST(NDSTEST, testRadiusCoverSmall) {
+  Wgs84Coordinate munich(11.575, 48.137);
+  std::vector<TileRange> ranges = coverRadius(munich, 1000, 13);
+  EXPECT_LE(4u, toSet(ranges).size());
+}
+
+TEST(NDSTEST, testRingCover) {
+  NdsTile tile(13, Wgs84Coordinate(11.575, 48.137));
+  NdsBbox b = tile.getBBox();
+  std::set<int> ring = toSet(coverRing(tile, 1));
+  EXPECT_EQ(9u, ring.size());
+  int width = tileWidth(13), height = tileHeight(13);
+  for (int dx : {-1, 0, 1}) {
+    for (int dy : {-1, 0, 1}) {
+      NdsCoordinate c(b.west() + dx * width, b.south() + dy * height);
+      EXPECT_EQ(1u, ring.count(NdsTile(13, c).tileNumber()));
+    }
+  }
+  EXPECT_EQ(std::set<int>({tile.tileNumber()}), toSet(coverRing(tile, 0)));
+  EXPECT_EQ(25u, toSet(coverRing(tile, 2)).size());
+
+  // Across the antimeridian and clipped at the north pole.
+  NdsTile corner(10, NdsCoordinate(kMaxLongitude, kMaxLatitude));
+  std::set<int> wrapped = toSet(coverRing(corner, 1));
+  EXPECT_EQ(6u, wrapped.size());
+  EXPECT_EQ(1u, wrapped.count(
+                    NdsTile(10, NdsCoordinate(kMinLongitude, kMaxLatitude))
+                        .tileNumber()));
+  EXPECT_EQ(1u, wrapped.count(NdsTile(10, NdsCoordinate(
+                                              kMinLongitude,
+                                              kMaxLatitude - tileHeight(10)))
+                                  .tileNumber()));
+
+  // Large rings cover the whole level.
+  std::vector<TileRange> all = coverRing(NdsTile(3, 5), 100);
+  ASSERT_EQ(1u, all.size());
+  EXPECT_EQ(TileRange({0, (1 << 7) - 1}), all[0]);
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
@@ -0,0 +1,308 @@
+#include "nds/nds_tile_set.h"
+//
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <set>
+#include <unordered_set>
+#include <vector>
+//
+#include "nds/nds_tile_cover.h"
+
+namespace nds {
+namespace {
+/*
+ * Random tile numbers, dense within a few Morton blocks and sparse
+ * elsewhere, so both container kinds are used.
+ */
+std::set<int> randomNumbers(std::mt19937 *rng, int level) {
+  std::set<int> numbers;
+  const uint32_t count = 1u << (2 * level + 1);
+  for (int i = 0; i < 3000; i++) {
+    numbers.insert((int)((*rng)() % count));
+  }
+  for (int block = 0; block < 3; block++) {
+    uint32_t base = (*rng)() % count & ~0xFFFFu;
+    for (int i = 0; i < 20000; i++) {
+      uint32_t nr = base + (uint32_t)((*rng)() % 0x10000);
+      numbers.insert((int)std::min(count - 1, nr));
+    }
+  }
+  return numbers;
+}
+
+std::set<int> toSet(const TileBitmap &bitmap) {
+  std::set<int> numbers;
+  int last = -1;
+  bitmap.forEach([&](int nr) {
+    // Ascending order.
+    EXPECT_LT(last, nr);
+    last = nr;
+    numbers.insert(nr);
+  });
+  return numbers;
+}
+
+TileSet toTileSet(const std::set<int> &numbers, int level) {
+  TileSet set;
+  for (int nr : numbers) {
+    set.insert(NdsTile(level, nr));
+  }
+  return set;
+}
+} // namespace
+
+TEST(NDSTEST, testTileSetOperationsMatchStdSet) {
+  std::mt19937 rng(17);
+  const int level = 13;
+  for (int n = 0; n < 5; n++) {
+    std::set<int> a = randomNumbers(&rng, level);
+    std::set<int> b = randomNumbers(&rng, level);
+    // Overlap a few containers.
+    for (int nr : a) {
+      if (rng() % 3 == 0) {
+        b.insert(nr);
+      }
+    }
+    TileSet sa = toTileSet(a, level), sb = toTileSet(b, level);
+    EXPECT_EQ(a.size(), sa.size());
+    EXPECT_EQ(a, toSet(sa.level(level)));
+
+    std::set<int> expected;
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                   std::inserter(expected, expected.end()));
+    EXPECT_EQ(expected, toSet((sa | sb).level(level)));
+    EXPECT_TRUE((sa | sb) == toTileSet(expected, level));
+    expected.clear();
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                          std::inserter(expected, expected.end()));
+    EXPECT_EQ(expected, toSet((sa & sb).level(level)));
+    EXPECT_TRUE((sa & sb) == toTileSet(expected, level));
+    expected.clear();
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                        std::inserter(expected, expected.end()));
+    EXPECT_EQ(expected, toSet((sa - sb).level(level)));
+    EXPECT_TRUE((sa - sb) == toTileSet(expected, level));
+    EXPECT_TRUE((sa - sa).empty());
+
+    for (int i = 0; i < 1000; i++) {
+      int nr = (int)(rng() % (1u << (2 * level + 1)));
+      EXPECT_EQ(a.count(nr) == 1, sa.contains(NdsTile(level, nr)));
+    }
+    // Removing everything leaves an empty set.
+    for (int nr : a) {
+      ASSERT_TRUE(sa.erase(NdsTile(level, nr)));
+    }
+    EXPECT_FALSE(sa.erase(NdsTile(level, *a.begin())));
+    EXPECT_TRUE(sa.empty());
+  }
+}
+
+TEST(NDSTEST, testTileSetRanges) {
+  TileSet set;
+  set.insert(10, {100, 70000});
+  set.insert(10, {70001, 70001});
+  set.insert(10, {200000, 200010});
+  set.insert(NdsTile(10, 5));
+  set.insert(NdsTile(0, 1));
+  EXPECT_EQ(70001u - 100 + 1 + 11 + 1, set.level(10).cardinality());
+  std::vector<TileRange> ranges = set.level(10).ranges();
+  std::vector<TileRange> expected = {{5, 5}, {100, 70001}, {200000, 200010}};
+  EXPECT_EQ(expected, ranges);
+  EXPECT_EQ(1u, set.level(0).cardinality());
+
+  std::vector<NdsTile> tiles;
+  set.forEach([&](const NdsTile &tile) { tiles.push_back(tile); });
+  ASSERT_EQ(set.size(), tiles.size());
+  EXPECT_TRUE(tiles.front() == NdsTile(0, 1));
+  EXPECT_TRUE(tiles[1] == NdsTile(10, 5));
+}
+
+TEST(NDSTEST, testTileBitmapBatchRanges) {
+  std::mt19937 rng(23);
+  const int level = 13;
+  for (int n = 0; n < 5; n++) {
+    std::set<int> numbers = randomNumbers(&rng, level);
+    // Sorted disjoint ranges of random lengths, some spanning containers.
+    std::vector<TileRange> ranges;
+    int64_t nr = rng() % 1000;
+    while (nr < (1 << (2 * level + 1))) {
+      int64_t length = n % 2 == 0 ? rng() % 50 : rng() % 200000;
+      int64_t last = std::min<int64_t>(nr + length, (1 << (2 * level + 1)) - 1);
+      ranges.push_back({(int)nr, (int)last});
+      nr = last + 2 + rng() % (n % 2 == 0 ? 5000 : 300000);
+    }
+    TileBitmap single, batch;
+    for (int v : numbers) {
+      single.add(v);
+      batch.add(v);
+    }
+    for (const TileRange &r : ranges) {
+      single.remove(r);
+    }
+    batch.remove(ranges);
+    EXPECT_EQ(toSet(single), toSet(batch));
+    EXPECT_TRUE(single == batch);
+
+    for (const TileRange &r : ranges) {
+      single.add(r);
+    }
+    batch.add(ranges);
+    EXPECT_TRUE(single == batch);
+  }
+}
+
+TEST(NDSTEST, testTileSetSerialization) {
+  std::mt19937 rng(18);
+  TileSet set = toTileSet(randomNumbers(&rng, 13), 13);
+  set |= toTileSet(randomNumbers(&rng, 8), 8);
+  set.insert(NdsTile(0, 0));
+  set.insert(NdsTile(15, std::numeric_limits<int>::max()));
+  std::vector<uint8_t> data;
+  set.serialize(&data);
+  Result<TileSet> read = TileSet::deserialize(data.data(), data.size());
+  ASSERT_TRUE(read.ok());
+  EXPECT_TRUE(read.value() == set);
+
+  std::vector<uint8_t> empty;
+  TileSet().serialize(&empty);
+  EXPECT_EQ(6u, empty.size());
+  EXPECT_TRUE(TileSet::deserialize(empty.data(), empty.size()).value().empty());
+
+  // Truncated and corrupted data is rejected.
+  for (size_t size : {0ul, 3ul, 5ul, 6ul, data.size() / 2, data.size() - 1}) {
+    EXPECT_EQ(Status::kInvalidData,
+              TileSet::deserialize(data.data(), size).status());
+  }
+  std::vector<uint8_t> corrupt = data;
+  corrupt[4] ^= 0x02; // Claims a level 1 bitmap.
+  EXPECT_FALSE(TileSet::deserialize(corrupt.data(), corrupt.size()).ok());
+  corrupt = data;
+  corrupt.push_back(0);
+  EXPECT_FALSE(TileSet::deserialize(corrupt.data(), corrupt.size()).ok());
+}
+
+TEST(NDSTEST, testTileSetMemoryUsage) {
+  // The level 13 coverage of Germany plus sparse tiles around the world.
+  std::vector<TileRange> germany =
+      coverRanges(Wgs84Bbox(55.1, 15.1, 47.2, 5.8), 13);
+  TileSet set;
+  std::unordered_set<int> packedIds;
+  for (const TileRange &range : germany) {
+    set.insert(13, range);
+  }
+  std::mt19937 rng(19);
+  for (int i = 0; i < 10000; i++) {
+    set.insert(NdsTile(13, (int)(rng() % (1u << 27))));
+  }
+  set.forEach([&](const NdsTile &tile) { packedIds.insert(tile.packedId()); });
+  EXPECT_EQ(packedIds.size(), set.size());
+  std::vector<uint8_t> data;
+  set.serialize(&data);
+  double bytesPerTile = (double)set.memoryUsage() / set.size();
+  LOG(INFO) << set.size() << " tiles, " << bytesPerTile
+            << " bytes per tile in memory, "
+            << (double)data.size() / set.size() << " serialized";
+  EXPECT_GT(4.0, bytesPerTile);
+}
+
+TEST(NDSTEST, testTileSetNormalize) {
+  std::mt19937 rng(20);
+  for (int n = 0; n < 20; n++) {
+    // Random tiles of the levels 0..8, with complete and partial quads.
+    TileSet set;
+    for (int i = 0; i < 200; i++) {
+      int level = 2 + (int)(rng() % 7);
+      NdsTile tile(level, (int)(rng() % (1u << (2 * level + 1))));
+      if (i % 2 == 0 && level < 8) {
+        int children = 2 + (int)(rng() % 3);
+        for (int c = 0; c < children; c++) {
+          set.insert(tile.child(c));
+          if (i % 4 == 0 && level < 7) {
+            for (const NdsTile &grandChild : tile.child(c).children()) {
+              set.insert(grandChild);
+            }
+          }
+        }
+      } else {
+        set.insert(tile);
+      }
+    }
+    if (n == 0) {
+      set.insert(NdsTile(0, 1));
+    }
+    TileSet normalized = set;
+    normalized.normalize();
+    EXPECT_GE(set.size(), normalized.size());
+
+    // Same area.
+    TileSet a = set, b = normalized;
+    a.expand(8);
+    b.expand(8);
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.size(), a.level(8).cardinality());
+
+    // Minimal: no ancestors within the set and no complete quads.
+    normalized.forEach([&](const NdsTile &tile) {
+      for (int level = 0; level < tile.level(); level++) {
+        EXPECT_FALSE(normalized.contains(tile.ancestor(level))) << tile;
+      }
+      if (tile.level() > 0) {
+        int siblings = 0;
+        for (const NdsTile &sibling : tile.parent().children()) {
+          siblings += normalized.contains(sibling) ? 1 : 0;
+        }
+        EXPECT_GT(4, siblings) << tile;
+      }
+    });
+    // Idempotent.
+    TileSet twice = normalized;
+    twice.normalize();
+    EXPECT_TRUE(twice == normalized);
+  }
+
+  // The four children of both hemispheres collapse to level 0.
+  TileSet world;
+  world.insert(1, {0, 7});
+  world.normalize();
+  EXPECT_EQ(2u, world.size());
+  EXPECT_TRUE(world.contains(NdsTile(0, 0)) && world.contains(NdsTile(0, 1)));
+  world.expand(2);
+  EXPECT_EQ(32u, world.size());
+  world.expand(0);
+  EXPECT_EQ(2u, world.level(0).cardinality());
+}
+
+TEST(NDSTEST, testTileSetNormalizeCover) {
+  // A level 13 polygon cover, as shipped in tile lists.
+  std::vector<std::vector<Wgs84Coordinate>> polygon = {
+      {Wgs84Coordinate(5.9, 47.3), Wgs84Coordinate(15.0, 47.3),
+       Wgs84Coordinate(15.0, 51.0), Wgs84Coordinate(9.0, 55.0),
+       Wgs84Coordinate(5.9, 51.0)}};
+  PolygonCover cover = coverPolygon(polygon, 13);
+  TileSet set;
+  for (const std::vector<TileRange> *ranges :
+       {&cover.interior, &cover.boundary}) {
+    for (const TileRange &range : *ranges) {
+      set.insert(13, range);
+    }
+  }
+  TileSet normalized = set;
+  normalized.normalize();
+  EXPECT_LT(normalized.size() * 5, set.size());
+  normalized.expand(13);
+  EXPECT_TRUE(normalized == set);
+}
+
+} // namespace nds
+int main(int argc, char **argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+  FLAGS_logtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  LOG(INFO) << "Run Test ...";
+  const int output = RUN_ALL_TESTS();
+  return output;
+}
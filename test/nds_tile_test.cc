@@ -3,6 +3,9 @@
 #include <gtest/gtest.h>
 //
 #include "nds/nds_tile.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
 
 namespace nds {
 constexpr double kEps = 1e-7;
@@ -270,6 +273,244 @@ TEST(NDSTEST, testCenterWorks) {
     EXPECT_EQ(-180.0 / londiv, wgs.longitude());
   }
 }
+TEST(NDSTEST, testNonFatalFactories) {
+  Result<NdsTile> t = NdsTile::fromPackedId(539636700);
+  ASSERT_TRUE(t.ok());
+  EXPECT_EQ(13, t.value().level());
+  EXPECT_EQ(2765788, t.value().tileNumber());
+  EXPECT_EQ(539636700, t.value().packedId());
+  EXPECT_EQ(kMinLongitude,
+            NdsTile::fromPackedId(kMinLongitude).value().packedId());
+  EXPECT_EQ(Status::kInvalidPackedId, NdsTile::fromPackedId(42).status());
+  EXPECT_EQ(Status::kInvalidTileNumber,
+            NdsTile::fromPackedId((1 << 16) | 5).status());
+  EXPECT_EQ(Status::kInvalidTileNumber,
+            NdsTile::fromPackedId((1 << 30) | (1 << 29)).status());
+  EXPECT_TRUE(NdsTile::fromPackedId((1 << 16) | 1));
+  EXPECT_TRUE(NdsTile::fromPackedId((1 << 30) | ((1 << 29) - 1)));
+  EXPECT_TRUE(NdsTile::fromPackedId(-1));
+
+  t = NdsTile::create(13, NdsCoordinate(24772607, 493486079));
+  ASSERT_TRUE(t);
+  EXPECT_EQ(2765788, t.value().tileNumber());
+  t = NdsTile::create(10, Wgs84Coordinate(30, -34));
+  ASSERT_TRUE(t);
+  EXPECT_EQ(675564, t.value().tileNumber());
+
+  EXPECT_TRUE(NdsTile::create(0, 1));
+  EXPECT_TRUE(NdsTile::create(15, kMaxLongitude));
+  EXPECT_EQ(Status::kInvalidLevel, NdsTile::create(-1, 0).status());
+  EXPECT_EQ(Status::kInvalidLevel, NdsTile::create(16, 0).status());
+  EXPECT_EQ(Status::kInvalidLevel,
+            NdsTile::create(16, NdsCoordinate(0, 0)).status());
+  EXPECT_EQ(Status::kInvalidTileNumber, NdsTile::create(0, 2).status());
+  EXPECT_EQ(Status::kInvalidTileNumber, NdsTile::create(3, -1).status());
+}
+TEST(NDSTEST, testTileIsFlatValue) {
+  NdsTile t(539636700);
+  NdsCoordinate center = t.getCenter();
+  // Copies must stay independent of each other.
+  NdsTile copy = t;
+  t = NdsTile(10, 675564);
+  EXPECT_TRUE(center == copy.getCenter());
+  EXPECT_EQ(539636700, copy.packedId());
+
+  std::vector<NdsTile> tiles(1000, copy);
+  std::vector<NdsTile> copied(tiles.size(), t);
+  std::memcpy(copied.data(), tiles.data(), tiles.size() * sizeof(NdsTile));
+  EXPECT_TRUE(copied.back() == copy);
+  EXPECT_TRUE(copied.back().getBBox() == copy.getBBox());
+}
+TEST(NDSTEST, testTileMathIsConstexpr) {
+  static_assert(tileWidth(1) == kMaxLongitude / 2, "");
+  static_assert(tileHeight(1) == kMaxLatitude, "");
+  static_assert(levelBit(13) == 1 << 29, "");
+  static_assert(levelBit(15) == kMinLongitude, "");
+  static_assert(NdsBbox::WEST_HEMISPHERE().west() == kMinLongitude, "");
+
+  // Barcelona area, see testFixedData.
+  constexpr NdsTile t(539636700);
+  static_assert(t.level() == 13 && t.tileNumber() == 2765788, "");
+  static_assert(NdsTile::extractLevel(-2103231037) == 15, "");
+  static_assert(t.getCenter() == NdsCoordinate(24772607, 493486079), "");
+  static_assert(t.getBBox() == NdsBbox(493617151, 24903679, 493355008,
+                                       24641536),
+                "");
+  static_assert(t.contains(NdsCoordinate(24772607, 493486079)), "");
+  static_assert(NdsTile(13, NdsCoordinate(24772607, 493486079)) == t, "");
+  static_assert(NdsTile(2, 30).getCenter() ==
+                    NdsCoordinate(kMinLongitude / 8 * 3, kMinLatitude / 4),
+                "");
+
+  // The runtime dispatched path gives the same results.
+  NdsTile runtime(539636700);
+  EXPECT_TRUE(runtime.getBBox() == t.getBBox());
+  EXPECT_TRUE(runtime.getCenter() == t.getCenter());
+  EXPECT_EQ(t.southWestAsMorton(), runtime.southWestAsMorton());
+}
+TEST(NDSTEST, testExtractLevelMatchesBitScan) {
+  // The former bit by bit scan, kept as reference.
+  auto reference = [](int packedId) {
+    for (int lvl = kMaxLevel; lvl > -1; lvl--) {
+      if ((packedId & (int)(1u << (16 + lvl))) > 0) {
+        return lvl;
+      }
+      if (packedId < 0 && lvl == kMaxLevel)
+        return kMaxLevel;
+    }
+    return -1;
+  };
+  const int ids[] = {0, 1, 0xFFFF, 1 << 16, 1 << 30, kMaxLongitude,
+                     kMinLongitude, -1, 539636700};
+  for (int id : ids) {
+    EXPECT_EQ(reference(id), NdsTile::extractLevel(id)) << "id: " << id;
+  }
+  for (int i = 0; i < 100000; i++) {
+    int id = (int)((unsigned)std::rand() << 1 ^ (unsigned)std::rand() >> 3);
+    ASSERT_EQ(reference(id), NdsTile::extractLevel(id)) << "id: " << id;
+  }
+  static_assert(NdsTile::extractLevel(0x7FFF) == -1, "");
+  static_assert(NdsTile::extractLevel(1 << 16) == 0, "");
+}
+TEST(NDSTEST, testHierarchyNavigation) {
+  // Barcelona area, see testFixedData.
+  constexpr NdsTile t(539636700);
+  static_assert(t.parent().level() == 12, "");
+  static_assert(t.ancestor(13) == t, "");
+  static_assert(t.child(3).parent() == t, "");
+  static_assert(t.descendants(13) == TileRange{t.tileNumber(), t.tileNumber()},
+                "");
+  static_assert(NdsTile::commonAncestorLevel(t, t.child(2).child(1)) == 13,
+                "");
+
+  // Parents contain the tile center, children cover the tile in Morton
+  // order.
+  for (int level = 1; level <= kMaxLevel; level++) {
+    NdsTile tile(level, t.getCenter());
+    EXPECT_TRUE(tile.parent() == NdsTile(level - 1, tile.getCenter()));
+    for (int a = 0; a <= level; a++) {
+      EXPECT_TRUE(tile.ancestor(a) == NdsTile(a, tile.getCenter()));
+    }
+  }
+  NdsTile parent(10, 675564);
+  std::array<NdsTile, 4> children = parent.children();
+  NdsBbox b = parent.getBBox();
+  EXPECT_TRUE(children[0].getBBox().southWest() == b.southWest());
+  EXPECT_TRUE(children[1].getBBox().southEast() == b.southEast());
+  EXPECT_TRUE(children[2].getBBox().northWest() == b.northWest());
+  EXPECT_TRUE(children[3].getBBox().northEast() == b.northEast());
+  for (const NdsTile &child : children) {
+    EXPECT_TRUE(child.parent() == parent);
+    EXPECT_TRUE(children == child.siblings());
+  }
+  static_assert(t.siblings()[t.tileNumber() & 3] == t, "");
+  EXPECT_TRUE(NdsTile(1, 6).siblings()[0] == NdsTile(1, 4));
+  EXPECT_TRUE(NdsTile(15, 0).siblings()[3] == NdsTile(15, 3));
+  EXPECT_DEATH(NdsTile(0, 1).siblings(), "No such parent");
+
+  // Level 0 consists of two hemispheres, each with four children.
+  EXPECT_TRUE(NdsTile(0, 1).child(0) == NdsTile(1, 4));
+  EXPECT_TRUE(NdsTile(1, 7).parent() == NdsTile(0, 1));
+  EXPECT_EQ(TileRange({1 << 30, (int)((1u << 31) - 1)}),
+            NdsTile(0, 1).descendants(kMaxLevel));
+  EXPECT_EQ(-1, NdsTile::commonAncestorLevel(NdsTile(1, 3), NdsTile(1, 4)));
+  EXPECT_EQ(0, NdsTile::commonAncestorLevel(NdsTile(1, 3), NdsTile(1, 0)));
+}
+TEST(NDSTEST, testDescendantsAndCommonAncestor) {
+  for (int level = 0; level <= 3; level++) {
+    for (int nr = 0; nr < (1 << (2 * level + 1)); nr++) {
+      NdsTile tile(level, nr);
+      for (int deeper = level; deeper <= level + 3; deeper++) {
+        TileRange range = tile.descendants(deeper);
+        for (int d = 0; d < (1 << (2 * deeper + 1)); d++) {
+          bool inRange = range.first <= d && d <= range.last;
+          ASSERT_EQ(inRange, NdsTile(deeper, d).ancestor(level) == tile);
+        }
+      }
+    }
+  }
+  // Reference: climb both tiles until they meet.
+  auto reference = [](NdsTile a, NdsTile b) {
+    while (a.level() > b.level()) {
+      a = a.parent();
+    }
+    while (b.level() > a.level()) {
+      b = b.parent();
+    }
+    while (!(a == b)) {
+      if (a.level() == 0) {
+        return -1;
+      }
+      a = a.parent();
+      b = b.parent();
+    }
+    return a.level();
+  };
+  std::srand(13);
+  for (int i = 0; i < 100000; i++) {
+    int la = std::rand() % (kMaxLevel + 1), lb = std::rand() % (kMaxLevel + 1);
+    NdsTile a(la, (int)((unsigned)std::rand() % (1u << (2 * la + 1))));
+    // Derive b from a in most cases, so common ancestors are deep.
+    NdsTile b(lb, (int)((unsigned)std::rand() % (1u << (2 * lb + 1))));
+    if (i % 4 != 0 && lb >= la) {
+      int nr = a.descendants(lb).first;
+      b = NdsTile(lb, nr + std::rand() % (int)a.descendants(lb).size());
+      if (i % 4 == 1 && la > 0) {
+        b = NdsTile(lb, b.tileNumber() ^ (1 << std::rand() % (2 * lb + 1)));
+      }
+    }
+    ASSERT_EQ(reference(a, b), NdsTile::commonAncestorLevel(a, b))
+        << a << " / " << b;
+  }
+}
+TEST(NDSTEST, testNeighborsMatchCoordinates) {
+  // Reference: the tile containing the center moved by whole tiles.
+  auto reference = [](const NdsTile &tile, int dx, int dy) {
+    NdsCoordinate c = tile.getCenter();
+    int64_t lon = (int64_t)c.longitude() + (int64_t)dx * (kLongitudeRange >>
+                                                          (tile.level() + 1));
+    int64_t lat = (int64_t)c.latitude() + (int64_t)dy * (kLatitudeRange >>
+                                                         tile.level());
+    // Wrap around at the antimeridian, clamp at the poles.
+    lon = (int64_t)(int32_t)(uint32_t)lon;
+    if (lat < kMinLatitude || kMaxLatitude < lat) {
+      lat = c.latitude();
+    }
+    return NdsTile(tile.level(), NdsCoordinate((int)lon, (int)lat));
+  };
+  std::srand(14);
+  for (int i = 0; i < 20000; i++) {
+    int level = i % (kMaxLevel + 1);
+    int nr = (int)((unsigned)std::rand() % (1u << (2 * level + 1)));
+    // Include the tiles at the antimeridian and the poles.
+    if (i % 5 == 0) {
+      nr = NdsTile(level, NdsCoordinate(i % 2 ? kMaxLongitude : kMinLongitude,
+                                        i % 3 ? kMaxLatitude : kMinLatitude))
+               .tileNumber();
+    }
+    NdsTile tile(level, nr);
+    std::array<NdsTile, 9> window = tile.window();
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        ASSERT_EQ(reference(tile, dx, dy), window[(dy + 1) * 3 + dx + 1])
+            << tile << " dx " << dx << " dy " << dy;
+      }
+    }
+    std::array<NdsTile, 4> edges = tile.edgeNeighbors();
+    EXPECT_EQ(window[5], edges[0]);
+    EXPECT_EQ(window[7], edges[1]);
+    EXPECT_EQ(window[3], edges[2]);
+    EXPECT_EQ(window[1], edges[3]);
+    EXPECT_EQ(!(tile.north() == tile), tile.hasNorth());
+    EXPECT_EQ(!(tile.south() == tile), tile.hasSouth());
+  }
+  // Level 0: the hemispheres are each other's east and west neighbors.
+  static_assert(NdsTile(0, 0).east() == NdsTile(0, 1), "");
+  static_assert(NdsTile(0, 0).west() == NdsTile(0, 1), "");
+  static_assert(!NdsTile(0, 1).hasNorth() && !NdsTile(0, 1).hasSouth(), "");
+  constexpr NdsTile t(539636700);
+  static_assert(t.east().west() == t && t.north().south() == t, "");
+}
 } // namespace nds
 int main(int argc, char **argv) {
   google::InitGoogleLogging(argv[0]);